@@ -0,0 +1,329 @@
+/**
+ * accuracy-main.cpp
+ *
+ * Accuracy map of the production kernels. The field of a coil set is taken
+ * over a grid of the (r, z) plane by the reference solver, and by the
+ * fixed-order evaluation of every kernel in every accuracy tier; each mode
+ * reports the largest and the 99th percentile relative error by region,
+ * and its single thread cost. The reference is checked against the on-axis
+ * field in closed form first. --map writes the error of every mode at
+ * every node of the grid.
+ *
+ * The error of a probe is relative to |B| there, or to ACC_FLOOR times the
+ * largest |B| of the grid where the field is weaker, so that the nulls of
+ * coil sets of opposite currents do not dominate.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <argp.h>
+#include <omp.h>
+
+#include "../core/solb.h"
+#include "../core/reference.h"
+#include "../io/text-io.h"
+
+#define ACC_FLOOR 1e-3 // Smallest |B| an error is relative to, of the largest of the grid
+#define ACC_NEAR 0.01 // Distance from a winding within which a probe is near it, in m
+#define ACC_DSV 0.2 // Radius of the spherical volume about the origin, in m
+
+static const char *acc_regions[] = { "axis", "dsv", "near", "inside", "other" };
+#define ACC_NREGION 5
+
+/* The 8-coil magnet of build/coil.txt in m and A/m^2. */
+static const double acc_magnet[8][5] = {
+	{ .5, .5228, -.1974, .1974, 4.761905e8 },
+	{ .5, .5140, -.0672, .0672, -4.761905e8 },
+	{ .5, .5050, .0672, .1932, -4.761905e8 },
+	{ .5, .5050, -.1932, -.0672, -4.761905e8 },
+	{ .5, .5080, .1974, .4054, 3.846154e8 },
+	{ .5, .5080, -.4054, -.1974, 3.846154e8 },
+	{ .5, .5320, .4054, .7774, 3.225806e8 },
+	{ .5, .5320, -.7774, -.4054, 3.225806e8 }
+};
+
+const char *argp_program_version = "accuracy 1.0";
+
+static char doc[] =
+	"accuracy -- Error of the production kernels over the (r, z) plane against the extended-precision reference.";
+
+static struct argp_option options[] = {
+	{ "coil",	'c', "FILE",	0, "Coil data input (default the 8-coil magnet of build/coil.txt)" },
+	{ "grid",	'r', "RMIN:RMAX:NR,ZMIN:ZMAX:NZ", 0, "Grid of the map (default 0:1:101,-1:1:201)" },
+	{ "order",	'q', "N",		0, "Compiled quadrature order of every mode (default 8)" },
+	{ "map",	'o', "FILE",	0, "Write the reference field and the error of every mode at every node to FILE" },
+	{ 0 }
+};
+
+struct arguments
+{
+	char *coil_file;
+	char *map_file;
+	int order;
+	double grid_r[2];
+	double grid_z[2];
+	int grid_nr;
+	int grid_nz;
+};
+
+static error_t
+parse_opt(int key, char *arg, struct argp_state *state)
+{
+	struct arguments *arguments = (struct arguments *)state->input;
+	switch (key)
+	{
+		case 'c':
+			arguments->coil_file = arg;
+			break;
+		case 'r':
+			if (sscanf(arg, "%lf:%lf:%d,%lf:%lf:%d", &arguments->grid_r[0], &arguments->grid_r[1],
+						&arguments->grid_nr, &arguments->grid_z[0], &arguments->grid_z[1],
+						&arguments->grid_nz) != 6
+					|| arguments->grid_nr < 1 || arguments->grid_nz < 1)
+				argp_error(state, "Wrong grid %s", arg);
+			break;
+		case 'q':
+			arguments->order = atoi(arg);
+			if (arguments->order < QUAD_ORDER_MIN || arguments->order > QUAD_ORDER_MAX)
+				argp_error(state, "Quadrature order should be in [%d, %d]", QUAD_ORDER_MIN,
+						QUAD_ORDER_MAX);
+			break;
+		case 'o':
+			arguments->map_file = arg;
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	options,
+	parse_opt,
+	0,
+	doc
+};
+
+/* Region of a probe; windings take precedence over the volumes. */
+static int
+acc_region(const std::vector<top_solenoid_t> &sols, double r, double z)
+{
+	double dmin = INFINITY;
+	for (size_t j = 0; j < sols.size(); ++j)
+	{
+		const top_solenoid_t *s = &sols[j];
+		double dr = r < s->a1 ? s->a1 - r : (r > s->a2 ? r - s->a2 : 0);
+		double dz = z < s->b1 ? s->b1 - z : (z > s->b2 ? z - s->b2 : 0);
+		if (dr == 0 && dz == 0)
+			return 3;
+		dmin = std::min(dmin, sqrt(dr * dr + dz * dz));
+	}
+	if (dmin <= ACC_NEAR)
+		return 2;
+	if (r == 0)
+		return 0;
+	return r * r + z * z <= ACC_DSV * ACC_DSV ? 1 : 4;
+}
+
+/* Largest and 99th percentile of the errors of a region. */
+static void
+acc_stats(std::vector<double> *err, double *max, double *p99)
+{
+	if (err->empty())
+	{
+		*max = 0;
+		*p99 = 0;
+		return;
+	}
+	std::sort(err->begin(), err->end());
+	*max = err->back();
+	*p99 = (*err)[(size_t)(0.99 * (err->size() - 1))];
+}
+
+int
+main(int argc, char **argv)
+{
+	struct arguments arguments;
+	arguments.coil_file = NULL;
+	arguments.map_file = NULL;
+	arguments.order = 0;
+	arguments.grid_r[0] = 0;
+	arguments.grid_r[1] = 1;
+	arguments.grid_nr = 101;
+	arguments.grid_z[0] = -1;
+	arguments.grid_z[1] = 1;
+	arguments.grid_nz = 201;
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+
+	std::vector<top_solenoid_t> sols;
+	if (arguments.coil_file != NULL)
+	{
+		if (!text_parse_coils(arguments.coil_file, &sols))
+			exit(0);
+		if (sols.empty())
+		{
+			fprintf(stderr, "%s: No coils are properly specified", arguments.coil_file);
+			exit(0);
+		}
+	}
+	else
+	{
+		for (int j = 0; j < 8; ++j)
+			sols.push_back(top_solenoid_t(acc_magnet[j][0], acc_magnet[j][1], acc_magnet[j][2],
+						acc_magnet[j][3], acc_magnet[j][4]));
+	}
+	size_t ncoil = sols.size();
+	std::vector<solb_coil_t> ref(ncoil);
+	for (size_t j = 0; j < ncoil; ++j)
+	{
+		if (!solb_compile(&sols[j], &ref[j]))
+		{
+			fprintf(stderr, "Coil %zu is not properly specified", j + 1);
+			exit(0);
+		}
+	}
+
+	/* Grid, column by column in r */
+	size_t nr = arguments.grid_nr;
+	size_t nz = arguments.grid_nz;
+	size_t n = nr * nz;
+	double dr = nr > 1 ? (arguments.grid_r[1] - arguments.grid_r[0]) / (nr - 1) : 0;
+	double dz = nz > 1 ? (arguments.grid_z[1] - arguments.grid_z[0]) / (nz - 1) : 0;
+	std::vector<double> r(n);
+	std::vector<double> z(n);
+	std::vector<int> region(n);
+	for (size_t i = 0; i < nr; ++i)
+	{
+		for (size_t k = 0; k < nz; ++k)
+		{
+			r[i * nz + k] = arguments.grid_r[0] + dr * i;
+			z[i * nz + k] = arguments.grid_z[0] + dz * k;
+			region[i * nz + k] = acc_region(sols, r[i * nz + k], z[i * nz + k]);
+		}
+	}
+
+	/* Reference; probes cost very differently, so they are dealt dynamically */
+	std::vector<double> Br0(n);
+	std::vector<double> Bz0(n);
+	double begin = omp_get_wtime();
+#pragma omp parallel for schedule(dynamic, 16)
+	for (size_t i = 0; i < n; ++i)
+		ref_eval_batch(ref.data(), ncoil, &r[i], &z[i], 1, &Br0[i], &Bz0[i]);
+	double tref = omp_get_wtime() - begin;
+
+	double bmax = 0;
+	double axis_err = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		double mag = sqrt(Br0[i] * Br0[i] + Bz0[i] * Bz0[i]);
+		bmax = std::max(bmax, mag);
+		if (r[i] == 0)
+		{
+			double ax = ref_axis(ref.data(), ncoil, z[i]);
+			axis_err = std::max(axis_err, fabs(Bz0[i] - ax) / std::max(fabs(ax), 1e-300));
+		}
+	}
+	printf("Grid                 : %zu x %zu probes, %zu coils, |B| up to %.6lf T\n", nr, nz,
+			ncoil, bmax);
+	printf("Reference            : %.2lf s on %d threads, %.2le relative to the closed form on the axis\n\n",
+			tref, omp_get_max_threads(), axis_err);
+
+	/* Every kernel in every tier */
+	int nmode = 2 * SOLB_NTIER;
+	std::vector<double> err(nmode * n);
+	printf("%-8s%-6s%6s", "Kernel", "Tier", "Order");
+	for (int g = 0; g < ACC_NREGION; ++g)
+		printf("%20s", acc_regions[g]);
+	printf("%14s\n", "ns/query");
+	printf("%20s", "");
+	for (int g = 0; g < ACC_NREGION; ++g)
+		printf("%10s%10s", "max", "p99");
+	printf("\n");
+	for (int m = 0; m < nmode; ++m)
+	{
+		int kernel = m / SOLB_NTIER ? SOLB_KERNEL_CARLSON : SOLB_KERNEL_AGM;
+		int tier = m % SOLB_NTIER;
+		int order = arguments.order > 0 ? arguments.order : QUAD_ORDER;
+		std::vector<solb_coil_t> coils(ncoil);
+		for (size_t j = 0; j < ncoil; ++j)
+		{
+			solb_compile(&sols[j], &coils[j], order);
+			solb_set_kernel(&coils[j], kernel);
+			solb_set_tier(&coils[j], tier);
+		}
+
+		/* Single thread, columns sharing their quadrature state as in --grid */
+		std::vector<double> Br(n, 0.0);
+		std::vector<double> Bz(n, 0.0);
+		std::vector<double> Brj(nz);
+		std::vector<double> Bzj(nz);
+		begin = omp_get_wtime();
+		for (size_t i = 0; i < nr; ++i)
+		{
+			for (size_t j = 0; j < ncoil; ++j)
+			{
+				solb_eval_column(&coils[j], r[i * nz], &z[i * nz], nz, Brj.data(), Bzj.data());
+				for (size_t k = 0; k < nz; ++k)
+				{
+					Br[i * nz + k] += Brj[k];
+					Bz[i * nz + k] += Bzj[k];
+				}
+			}
+		}
+		double elapsed = omp_get_wtime() - begin;
+
+		std::vector<double> byregion[ACC_NREGION];
+		for (size_t i = 0; i < n; ++i)
+		{
+			double mag = sqrt(Br0[i] * Br0[i] + Bz0[i] * Bz0[i]);
+			double e = sqrt((Br[i] - Br0[i]) * (Br[i] - Br0[i]) + (Bz[i] - Bz0[i]) * (Bz[i] - Bz0[i]))
+				/ std::max(mag, ACC_FLOOR * bmax);
+			err[m * n + i] = e;
+			byregion[region[i]].push_back(e);
+		}
+		printf("%-8s%-6s%6d", kernel == SOLB_KERNEL_CARLSON ? "carlson" : "agm",
+				solb_tier_name(tier), order);
+		for (int g = 0; g < ACC_NREGION; ++g)
+		{
+			double max;
+			double p99;
+			acc_stats(&byregion[g], &max, &p99);
+			printf("%10.2le%10.2le", max, p99);
+		}
+		printf("%14.1lf\n", elapsed * 1e9 / n);
+		fflush(stdout);
+	}
+
+	if (arguments.map_file != NULL)
+	{
+		FILE *m_fp = fopen(arguments.map_file, "wt");
+		if (m_fp == NULL)
+		{
+			fprintf(stderr, "%s: No such file or directory", arguments.map_file);
+			exit(0);
+		}
+		fprintf(m_fp, "%16s%16s%16s%16s%8s", "Coord_R", "Coord_Z", "Br", "Bz", "Region");
+		for (int m = 0; m < nmode; ++m)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "%s/%s", m / SOLB_NTIER ? "carlson" : "agm",
+					solb_tier_name(m % SOLB_NTIER));
+			fprintf(m_fp, "%16s", name);
+		}
+		fprintf(m_fp, "\n");
+		for (size_t i = 0; i < n; ++i)
+		{
+			fprintf(m_fp, "%16lf%16lf%16.8le%16.8le%8s", r[i], z[i], Br0[i], Bz0[i],
+					acc_regions[region[i]]);
+			for (int m = 0; m < nmode; ++m)
+				fprintf(m_fp, "%16.3le", err[m * n + i]);
+			fprintf(m_fp, "\n");
+		}
+		fclose(m_fp);
+	}
+	return 0;
+}
@@ -12,15 +12,27 @@
  */
 
 #include <vector>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <argp.h>
 #include <omp.h>
 
 #include "../core/solb.h"
+#include "../core/zonal.h"
+#include "../core/fieldmap.h"
+#include "../core/mirror.h"
+#include "../core/stats.h"
+#include "../ic-check/ic-calc.h"
+#include "../inductance/inductance.h"
+#include "../force/force-calc.h"
+#include "../io/npy-io.h"
+#include "../io/text-io.h"
+#include "../tile/tile-sched.h"
+#include "../daemon/daemon.h"
 
-#define BUF_SIZE 200 // Buffer size in bytes for parsing of input files
-#define CHUNK_SIZE (1<<8) // Number of point probes to be fully evaluated before written on the disk
+#define ARRAY_CHUNK 1024 // Number of evaluated probes formatted by a thread at once
+#define STREAM_WINDOW (1<<20) // Probes read, evaluated and written at once by --stream
 
 
 const char *argp_program_version = "csolb 1.0";
@@ -31,10 +43,28 @@ static char doc[] =
 
 static struct argp_option options[] = {
     { "verbose",        'v', 0,         0, "Produce verbose output" },
-    { "interactive",    't', 0,         0, "Run in command line mode" },
+    { "interactive",    't', 0,         0, "Run as a daemon answering requests on stdin, or on the socket of --socket; the coil file, if any, is loaded as set \"default\"" },
+    { "socket",         'S', "PATH",    0, "Listen on the Unix-domain socket PATH in interactive mode" },
     { "coil",           'c', "FILE",    0, "Coil data input" },
     { "probe",          'p', "FILE",    0, "File of list of probes" },
     { "output",         'o', "FILE",    0, "Output file of B field strength" },
+    { "order",          'q', "N",       0, "Order of the radial Gauss-Legendre quadrature (2-32, default 8)" },
+    { "tolerance",      'e', "TOL",     0, "Pick the quadrature per probe to meet relative tolerance TOL" },
+    { "kernel",         'k', "NAME",    0, "Elliptic integral kernel; agm (default) or carlson" },
+    { "accuracy",       'a', "TIER",    0, "Accuracy tier of the fixed-order quadrature; full (default), ppb, ppm, single or fine. Relaxed tiers lower the order probe by probe, up to --order, and stop the kernels earlier; single runs the AGM iteration in float; fine grades the nodes near the windings and raises the order there" },
+    { "zonal",          'z', "N",       0, "Answer probes near the magnet center by a zonal harmonic expansion of order N (1-48)" },
+    { "map",            'M', "RMIN:RMAX:NR,ZMIN:ZMAX:NZ", 0, "Sample the field once on a map of NR x NZ nodes clear of every winding, and answer the probes on it by interpolation; all others are evaluated directly" },
+    { "interp",         'I', "MODE",    0, "Interpolation of --map; hermite (default) or linear" },
+    { "ic",             'i', "JC0,B0[,ALPHA[,K]]", 0, "Check every coil against the critical surface Jc = JC0 / (1 + sqrt((K Bz)^2 + Br^2) / B0)^ALPHA in A/mm^2 and T; no probe file is needed" },
+    { "gradient",       'g', 0,         0, "Append the Jacobian dBr/dr, dBr/dz, dBz/dr, dBz/dz in T/m; uses the fixed-order quadrature" },
+    { "inductance",     'm', 0,         0, "Compute the mutual inductance matrix per turn squared and the stored energy of the coil set; no probe file is needed" },
+    { "grid",           'r', "RMIN:RMAX:NR,ZMIN:ZMAX:NZ", 0, "Evaluate a structured grid of NR x NZ probes, including its ends, in place of a probe file; column by column in r" },
+    { "no-mirror",      'n', 0,         0, "Do not exploit mirror symmetry of the coils and the probes" },
+    { "force",          'f', "FILE",    OPTION_ARG_OPTIONAL, "Integrate the Lorentz force and the hoop stress over every coil; no probe file is needed. The distribution over the mesh goes to FILE, if given" },
+    { "stream",         's', "N",       OPTION_ARG_OPTIONAL, "Read, evaluate and write the probes N at a time (default 1048576), so that memory does not grow with the probe file" },
+    { "resume",         'R', "OFFSET",  0, "Resume a streamed run after its first OFFSET probes, keeping those already in the output file; implies --stream" },
+    { "numa",           'N', 0,         0, "Bind the threads to the NUMA nodes of the machine, in proportion to their CPUs, and give every node a contiguous share of the probes, of the results and a copy of the coils, first touched by its own threads" },
+    { "stats",          'T', "FILE",    OPTION_ARG_OPTIONAL, "Report timers of every phase, counters of the kernels, the histogram of AGM iterations and hardware counters at exit; on stderr, or as JSON to FILE" },
     { 0 }
 };
 
@@ -45,12 +75,43 @@ struct arguments
     char *coil_file;
     char *probe_file;
     char *output_file;
+    int order;
+    double tolerance;
+    int kernel;
+    int tier;
+    int zonal;
+    int map;
+    double map_r[2];
+    double map_z[2];
+    int map_nr;
+    int map_nz;
+    int interp;
+    int ic;
+    ic_model_t model;
+    int gradient;
+    int inductance;
+    int force;
+    char *force_file;
+    int no_mirror;
+    int grid;
+    double grid_r[2];
+    double grid_z[2];
+    int grid_nr;
+    int grid_nz;
+    size_t stream;
+    size_t resume;
+    char *socket_path;
+    int numa;
+    int stats;
+    char *stats_file;
 };
 
 static error_t
 parse_opt(int key, char *arg, struct argp_state *state)
 {
     struct arguments *arguments = (struct arguments *)state->input;
+    char *end;
+    long num;
     switch (key)
     {
         case 'v':
@@ -59,6 +120,10 @@ parse_opt(int key, char *arg, struct argp_state *state)
         case 't':
             arguments->interactive = 1;
             break;
+        case 'S':
+            arguments->socket_path = arg;
+            arguments->interactive = 1;
+            break;
         case 'c':
             arguments->coil_file = arg;
             break;
@@ -68,6 +133,101 @@ parse_opt(int key, char *arg, struct argp_state *state)
         case 'o':
             arguments->output_file = arg;
             break;
+        case 'q':
+            num = strtol(arg, &end, 10);
+            if (end == arg || *end != '\0' || num < QUAD_ORDER_MIN || num > QUAD_ORDER_MAX)
+                argp_error(state, "Quadrature order should be in [%d, %d]", QUAD_ORDER_MIN,
+                        QUAD_ORDER_MAX);
+            arguments->order = (int)num;
+            break;
+        case 'e':
+            arguments->tolerance = atof(arg);
+            break;
+        case 'k':
+            if (strcmp(arg, "agm") == 0)
+                arguments->kernel = SOLB_KERNEL_AGM;
+            else if (strcmp(arg, "carlson") == 0)
+                arguments->kernel = SOLB_KERNEL_CARLSON;
+            else
+                argp_error(state, "Unknown kernel %s", arg);
+            break;
+        case 'a':
+            if ((arguments->tier = solb_tier_parse(arg)) < 0)
+                argp_error(state, "Unknown accuracy tier %s", arg);
+            break;
+        case 'z':
+            num = strtol(arg, &end, 10);
+            if (end == arg || *end != '\0' || num < 1 || num > ZH_ORDER_MAX)
+                argp_error(state, "Zonal order should be in [1, %d]", ZH_ORDER_MAX);
+            arguments->zonal = (int)num;
+            break;
+        case 'M':
+            if (sscanf(arg, "%lf:%lf:%d,%lf:%lf:%d", &arguments->map_r[0], &arguments->map_r[1],
+                        &arguments->map_nr, &arguments->map_z[0], &arguments->map_z[1],
+                        &arguments->map_nz) != 6
+                    || arguments->map_nr < FM_MIN_NODES || arguments->map_nz < FM_MIN_NODES)
+                argp_error(state, "Wrong map %s, with at least %d nodes per direction", arg,
+                        FM_MIN_NODES);
+            arguments->map = 1;
+            break;
+        case 'I':
+            if (strcmp(arg, "hermite") == 0)
+                arguments->interp = FM_HERMITE;
+            else if (strcmp(arg, "linear") == 0)
+                arguments->interp = FM_LINEAR;
+            else
+                argp_error(state, "Unknown interpolation %s", arg);
+            break;
+        case 'i':
+            arguments->model.alpha = 1;
+            arguments->model.k = 1;
+            if (sscanf(arg, "%lf,%lf,%lf,%lf", &arguments->model.jc0, &arguments->model.b0,
+                        &arguments->model.alpha, &arguments->model.k) < 2)
+                argp_error(state, "Wrong critical surface %s", arg);
+            arguments->model.jc0 *= 1e6;
+            arguments->ic = 1;
+            break;
+        case 'g':
+            arguments->gradient = 1;
+            break;
+        case 'm':
+            arguments->inductance = 1;
+            break;
+        case 'n':
+            arguments->no_mirror = 1;
+            break;
+        case 'r':
+            if (sscanf(arg, "%lf:%lf:%d,%lf:%lf:%d", &arguments->grid_r[0], &arguments->grid_r[1],
+                        &arguments->grid_nr, &arguments->grid_z[0], &arguments->grid_z[1],
+                        &arguments->grid_nz) != 6
+                    || arguments->grid_nr < 1 || arguments->grid_nz < 1)
+                argp_error(state, "Wrong grid %s", arg);
+            arguments->grid = 1;
+            break;
+        case 'f':
+            arguments->force = 1;
+            arguments->force_file = arg;
+            break;
+        case 's':
+            arguments->stream = arg != NULL ? strtoul(arg, NULL, 10) : STREAM_WINDOW;
+            if (arguments->stream == 0)
+                argp_error(state, "Wrong window %s", arg);
+            break;
+        case 'R':
+            /* strtoul() would take "-1" for the largest offset */
+            arguments->resume = strtoul(arg, &end, 10);
+            if (arg[0] < '0' || arg[0] > '9' || *end != '\0')
+                argp_error(state, "Wrong offset %s", arg);
+            if (arguments->stream == 0)
+                arguments->stream = STREAM_WINDOW;
+            break;
+        case 'N':
+            arguments->numa = 1;
+            break;
+        case 'T':
+            arguments->stats = 1;
+            arguments->stats_file = arg;
+            break;
         default:
             return ARGP_ERR_UNKNOWN;
     }
@@ -82,11 +242,472 @@ static struct argp argp = {
     doc
 };
 
-int parse_coil(FILE *, std::vector<top_solenoid_t *> *);
-int parse_single_coil(char *, top_solenoid_t *);
-int parse_probe(FILE *, std::vector<vec2d_t> *);
 void run_interactive(struct arguments *);
 
+/* Destination of --stats; NULL for the report on stderr */
+static const char *stats_path = NULL;
+
+/* Merge the statistics of every thread and report them; runs at exit, so that every way out
+ * of main is covered */
+static void
+report_stats()
+{
+    stats_t st;
+    stats_merge(&st);
+    if (stats_path == NULL)
+    {
+        stats_print(stderr, &st);
+        return;
+    }
+    FILE *fp = fopen(stats_path, "wt");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "%s: No such file or directory", stats_path);
+        return;
+    }
+    stats_write_json(fp, &st);
+    fclose(fp);
+}
+
+/* Field of a single grid column summed over every coil */
+static void
+eval_column(double r, const double *z, size_t n, double *Br, double *Bz,
+        const std::vector<solb_coil_t> &ccoils, double tol, const zh_expansion_t *zh)
+{
+    std::vector<double> buf(3 * n);
+    double *rr = &buf[0];
+    double *Brj = rr + n;
+    double *Bzj = Brj + n;
+    for (size_t i = 0; i < n; ++i)
+    {
+        rr[i] = r;
+        Br[i] = 0;
+        Bz[i] = 0;
+    }
+    if (zh != NULL)
+        zh_eval_batch(zh, rr, z, n, Br, Bz);
+    for (size_t j = 0; j < ccoils.size() && zh == NULL; ++j)
+    {
+        if (tol > 0)
+            solb_eval_adaptive_batch(&ccoils[j], rr, z, n, tol, Brj, Bzj, NULL);
+        else
+            solb_eval_column(&ccoils[j], r, z, n, Brj, Bzj);
+        for (size_t i = 0; i < n; ++i)
+        {
+            Br[i] += Brj[i];
+            Bz[i] += Bzj[i];
+        }
+    }
+
+    /* Br is +0 on the plane of coils mirrored as a whole, as from tile_block() */
+    double zc;
+    if (mirror_whole(ccoils.data(), ccoils.size(), &zc))
+        mirror_zero(z, n, zc, Br);
+}
+
+/* Mirror plan of the z of grid columns; the symmetric coils are evaluated at the primary z
+ * only, and the other coils at every z */
+typedef struct _column_mirror_t
+{
+    std::vector<solb_coil_t> symc;
+    std::vector<solb_coil_t> rest;
+    std::vector<double> zprim;
+    std::vector<size_t> src;
+    std::vector<size_t> slot;
+} column_mirror_t;
+
+/* Field of a grid column, through its mirror plan if it has one */
+static void
+eval_grid_column(double r, const double *z, size_t n, double *Br, double *Bz,
+        const std::vector<solb_coil_t> &ccoils, double tol, const zh_expansion_t *zh,
+        const column_mirror_t *mir)
+{
+    if (mir == NULL)
+    {
+        eval_column(r, z, n, Br, Bz, ccoils, tol, zh);
+        return;
+    }
+
+    size_t nprim = mir->zprim.size();
+    std::vector<double> buf(2 * nprim);
+    eval_column(r, mir->zprim.data(), nprim, &buf[0], &buf[nprim], mir->symc, tol, NULL);
+    if (!mir->rest.empty())
+        eval_column(r, z, n, Br, Bz, mir->rest, tol, NULL);
+    for (size_t i = 0; i < n; ++i)
+    {
+        /* 0 - Br rather than -Br, so that a zero stays +0 as in the direct field */
+        size_t k = mir->slot[mir->src[i]];
+        double Bri = mir->src[i] != i ? 0.0 - buf[k] : buf[k];
+        Br[i] = mir->rest.empty() ? Bri : Bri + Br[i];
+        Bz[i] = mir->rest.empty() ? buf[nprim + k] : buf[nprim + k] + Bz[i];
+    }
+}
+
+/* Text output of probes held as arrays, a tile to a block; the field is taken from res if
+ * it has been evaluated already */
+typedef struct _probe_job_t
+{
+    const double *r;
+    const double *z;
+    const tile_job_t *tile;
+    double *const *res;
+} probe_job_t;
+
+static void
+write_probes(size_t block, text_buf_t *buf, void *ctx)
+{
+    const probe_job_t *job = (const probe_job_t *)ctx;
+    const tile_job_t *tile = job->tile;
+    size_t first = block * tile->probes;
+    size_t m = tile_size(tile, block);
+    int nout = tile_outputs(tile);
+    std::vector<double> loc(job->res == NULL ? nout * m : 0);
+    const double *res[6];
+    for (int k = 0; k < nout; ++k)
+        res[k] = job->res != NULL ? job->res[k] + first : &loc[k * m];
+    if (job->res == NULL)
+    {
+        unsigned long long t0 = stats_now();
+        double *out[6];
+        for (int k = 0; k < nout; ++k)
+            out[k] = &loc[k * m];
+        tile_block(tile, job->r, job->z, block, 0, out);
+        stats_time(STATS_T_EVAL, t0);
+    }
+
+    unsigned long long t0 = stats_now();
+    double row[8];
+    for (size_t i = 0; i < m; ++i)
+    {
+        row[0] = job->r[first + i];
+        row[1] = job->z[first + i];
+        for (int k = 0; k < nout; ++k)
+            row[k + 2] = res[k][i];
+        text_row(buf, row, nout + 2);
+    }
+    stats_time(STATS_T_FORMAT, t0);
+}
+
+/* Text output of a structured grid, a column to a block */
+typedef struct _grid_job_t
+{
+    double r0;
+    double dr;
+    const double *z;
+    size_t nz;
+    const std::vector<solb_coil_t> *ccoils;
+    double tol;
+    const zh_expansion_t *zh;
+    const column_mirror_t *mir;
+} grid_job_t;
+
+static void
+write_column(size_t block, text_buf_t *buf, void *ctx)
+{
+    const grid_job_t *job = (const grid_job_t *)ctx;
+    double r = job->r0 + job->dr * block;
+    std::vector<double> B(2 * job->nz);
+    unsigned long long t0 = stats_now();
+    eval_grid_column(r, job->z, job->nz, &B[0], &B[job->nz], *job->ccoils, job->tol, job->zh,
+            job->mir);
+    stats_time(STATS_T_EVAL, t0);
+
+    t0 = stats_now();
+    double row[4];
+    row[0] = r;
+    for (size_t k = 0; k < job->nz; ++k)
+    {
+        row[1] = job->z[k];
+        row[2] = B[k];
+        row[3] = B[job->nz + k];
+        text_row(buf, row, 4);
+    }
+    stats_time(STATS_T_FORMAT, t0);
+}
+
+/* Text output of probes whose field is composed of the field of the symmetric coils at the
+ * probe or at its image, and of the other coils at the probe */
+typedef struct _mirror_job_t
+{
+    const double *r;
+    const double *z;
+    size_t n;
+    const size_t *src;
+    const size_t *slot;
+    const unsigned char *flip;      /* Probes taking the field of their image, Br negated */
+    double *const *res_prim;
+    double *const *res_rest;
+} mirror_job_t;
+
+static void
+write_mirrored(size_t block, text_buf_t *buf, void *ctx)
+{
+    const mirror_job_t *job = (const mirror_job_t *)ctx;
+    size_t first = block * ARRAY_CHUNK;
+    size_t last = job->n - first < ARRAY_CHUNK ? job->n : first + ARRAY_CHUNK;
+    unsigned long long t0 = stats_now();
+    double row[4];
+    for (size_t i = first; i < last; ++i)
+    {
+        /* 0 - Br rather than -Br, so that a zero stays +0 as in the direct field */
+        size_t k = job->slot[job->src[i]];
+        mag_field_2d_t B(job->flip[i] ? 0.0 - job->res_prim[0][k] : job->res_prim[0][k],
+                job->res_prim[1][k]);
+        if (job->res_rest != NULL)
+        {
+            B.Br += job->res_rest[0][i];
+            B.Bz += job->res_rest[1][i];
+        }
+        row[0] = job->r[i];
+        row[1] = job->z[i];
+        row[2] = B.Br;
+        row[3] = B.Bz;
+        text_row(buf, row, 4);
+    }
+    stats_time(STATS_T_FORMAT, t0);
+}
+
+/* Print the header line of the text output */
+static void
+write_header(FILE *o_fp, int gradient)
+{
+    if (gradient)
+        fprintf(o_fp, "%16s%16s%16s%16s%16s%16s%16s%16s\n", "Coord_R", "Coord_Z", "Br", "Bz",
+                "dBr/dr", "dBr/dz", "dBz/dr", "dBz/dz");
+    else
+        fprintf(o_fp, "%16s%16s%16s%16s\n", "Coord_R", "Coord_Z", "Br", "Bz");
+}
+
+/*
+ * stream_mirrored
+ * Evaluate and write a window of text output through mirror symmetry. A probe above the plane
+ * always takes the field of the symmetric coils at its image, whether or not the image is a
+ * probe of the window, so that every probe is evaluated alike whatever the window; probes that
+ * coincide so are evaluated once. The other coils are evaluated at every probe.
+ */
+static void
+stream_mirrored(const double *r, const double *z, size_t m, double zc,
+        const std::vector<solb_coil_t> &symc, const std::vector<solb_coil_t> &rest, double tol,
+        const numa_topo_t *topo, FILE *o_fp)
+{
+    /* z + 0.0 turns a -0 into +0, so that both take the same representative */
+    std::vector<double> cz(m);
+    std::vector<size_t> idx(m);
+    std::vector<size_t> src(m);
+    for (size_t i = 0; i < m; ++i)
+    {
+        cz[i] = z[i] > zc ? 2 * zc - z[i] : z[i] + 0.0;
+        idx[i] = i;
+        src[i] = i;
+    }
+    std::sort(idx.begin(), idx.end(), [&](size_t p, size_t q) {
+        if (r[p] != r[q])
+            return r[p] < r[q];
+        if (cz[p] != cz[q])
+            return cz[p] < cz[q];
+        return p < q;
+    });
+
+    std::vector<double> prim_r;
+    std::vector<double> prim_z;
+    std::vector<size_t> slot(m);
+    std::vector<unsigned char> flip(m);
+    for (size_t s = 0; s < m; ++s)
+    {
+        size_t i = idx[s];
+        if (s == 0 || r[i] != r[idx[s - 1]] || cz[i] != cz[idx[s - 1]])
+        {
+            prim_r.push_back(r[i]);
+            prim_z.push_back(cz[i]);
+        }
+        slot[i] = prim_r.size() - 1;
+        flip[i] = z[i] > zc;
+    }
+
+    size_t nprim = prim_r.size();
+    std::vector<double> res(2 * nprim + (rest.empty() ? 0 : 2 * m));
+    double *res_prim[2] = { &res[0], &res[nprim] };
+    double *res_rest[2] = { &res[2 * nprim], &res[2 * nprim + m] };
+    tile_job_t tile;
+    unsigned long long t0 = stats_now();
+    tile_init(&tile, &symc[0], symc.size(), NULL, tol, 0, nprim);
+    tile_ungroup(&tile);
+    tile_eval_numa(&tile, topo, prim_r.data(), prim_z.data(), res_prim);
+    if (!rest.empty())
+    {
+        tile_init(&tile, &rest[0], rest.size(), NULL, tol, 0, m);
+        tile_ungroup(&tile);
+        tile_eval_numa(&tile, topo, r, z, res_rest);
+    }
+    stats_time(STATS_T_EVAL, t0);
+
+    mirror_job_t job = { r, z, m, src.data(), slot.data(), flip.data(), res_prim,
+        rest.empty() ? NULL : res_rest };
+    if (!text_pipe(o_fp, (m + ARRAY_CHUNK - 1) / ARRAY_CHUNK, write_mirrored, &job))
+        exit(0);
+}
+
+/*
+ * run_stream
+ * Evaluate the probes a window at a time; a window is read, evaluated and written before the
+ * next is read, and its pages are released once written, so that memory stays bounded by the
+ * window whatever the number of probes. Runs resume after a number of probes already written.
+ * Text output is mirrored window by window, see stream_mirrored(); binary output is not.
+ * Windows of binary output placed on the NUMA nodes are first touched by the node of each
+ * tile.
+ */
+static void
+run_stream(struct arguments *arguments, const std::vector<solb_coil_t> &ccoils,
+        const zh_expansion_t *zh, const fm_map_t *fm, const numa_topo_t *topo, int npy_in,
+        int npy_out, FILE *o_fp)
+{
+    size_t ncoil = ccoils.size();
+    size_t window = arguments->stream;
+    size_t done = arguments->resume;
+
+    /* Input; binary files are mapped and cut into windows in place */
+    npy_map_t in;
+    in.base = NULL;
+    text_stream_t ts;
+    ts.data = NULL;
+    size_t nprobe = 0;
+    if (npy_in)
+    {
+        if (!npy_open(arguments->probe_file, 2, 0, &in))
+            exit(0);
+        nprobe = in.n;
+        if (done > nprobe)
+        {
+            fprintf(stderr, "%s: Fewer probes than the offset", arguments->probe_file);
+            exit(0);
+        }
+    }
+    else
+    {
+        if (!text_stream_open(arguments->probe_file, &ts))
+            exit(0);
+        if (npy_out)
+            nprobe = text_stream_count(&ts);
+        if (!text_stream_skip(&ts, done))
+            exit(0);
+    }
+
+    /* Binary output is sized in full beforehand, and written in place window by window */
+    size_t rows = arguments->gradient ? 8 : 4;
+    npy_map_t out;
+    out.base = NULL;
+    if (npy_out)
+    {
+        if (done > 0 ? !npy_open(arguments->output_file, rows, 1, &out)
+                : !npy_create(arguments->output_file, rows, nprobe, &out))
+            exit(0);
+        if (out.n != nprobe)
+        {
+            fprintf(stderr, "%s: Holds %zu probes, not the %zu of %s", arguments->output_file,
+                    out.n, nprobe, arguments->probe_file);
+            exit(0);
+        }
+    }
+    else if (done == 0)
+        write_header(o_fp, arguments->gradient);
+
+    /* Mirror symmetry of the coils, for text output */
+    std::vector<long> partner(ncoil);
+    double zc = 0;
+    size_t nsym = (npy_out || zh != NULL || fm != NULL || arguments->no_mirror || arguments->gradient) ? 0
+        : mirror_coils(&ccoils[0], ncoil, &zc, &partner[0]);
+    std::vector<solb_coil_t> symc;
+    std::vector<solb_coil_t> rest;
+    for (size_t j = 0; j < ncoil && nsym > 0; ++j)
+        (partner[j] >= 0 ? symc : rest).push_back(ccoils[j]);
+    if (arguments->verbose && nsym > 0)
+        fprintf(stderr, "INFO: %zu of %zu coils are mirrored about z = %lf\n", nsym, ncoil, zc);
+
+    std::vector<double> wr;
+    std::vector<double> wz;
+    std::vector<double> ahead;
+    double start = omp_get_wtime();
+    size_t first = done;
+    while (1)
+    {
+        /* Next window */
+        const double *r;
+        const double *z;
+        size_t m;
+        if (npy_in)
+        {
+            m = nprobe - done < window ? nprobe - done : window;
+            r = in.data + done;
+            z = in.data + nprobe + done;
+        }
+        else
+        {
+            unsigned long long t0 = stats_now();
+            if (!text_stream_next(&ts, window, &wr, &wz))
+                exit(0);
+            stats_time(STATS_T_PARSE, t0);
+            m = wr.size();
+            r = wr.data();
+            z = wz.data();
+        }
+        if (m == 0)
+            break;
+
+        /* Coils are never split, so that results do not depend on the window */
+        tile_job_t tile;
+        tile_init(&tile, &ccoils[0], ncoil, zh, arguments->tolerance, arguments->gradient, m);
+        tile_ungroup(&tile);
+        if (fm != NULL)
+            tile_map(&tile, fm, arguments->interp);
+        if (npy_out)
+        {
+            double *res[6];
+            for (size_t k = 0; k < rows - 2; ++k)
+                res[k] = out.data + (k + 2) * nprobe + done;
+            if (topo != NULL)
+            {
+                tile_touch_numa(&tile, topo, r, z, out.data + done, out.data + nprobe + done, res);
+                r = out.data + done;
+                z = out.data + nprobe + done;
+            }
+            else
+            {
+                memcpy(out.data + done, r, m * sizeof(double));
+                memcpy(out.data + nprobe + done, z, m * sizeof(double));
+            }
+            unsigned long long t0 = stats_now();
+            tile_eval_numa(&tile, topo, r, z, res);
+            stats_time(STATS_T_EVAL, t0);
+            npy_release(&out, done, m);
+        }
+        else if (nsym > 0)
+        {
+            stream_mirrored(r, z, m, zc, symc, rest, arguments->tolerance, topo, o_fp);
+            fflush(o_fp);
+        }
+        else
+        {
+            probe_job_t job = { r, z, &tile, NULL };
+            if (!text_pipe(o_fp, tile.ntile, write_probes, &job))
+                exit(0);
+            fflush(o_fp);
+        }
+        if (npy_in)
+            npy_release(&in, done, m);
+        done += m;
+
+        double rate = (done - first) / (omp_get_wtime() - start);
+        if (nprobe > 0)
+            fprintf(stderr, "INFO: %zu of %zu probes done, %.0f probes/s\n", done, nprobe, rate);
+        else
+            fprintf(stderr, "INFO: %zu probes done, %.0f probes/s\n", done, rate);
+    }
+
+    text_stream_close(&ts);
+    npy_close(&in);
+    npy_close(&out);
+}
+
 int
 main(int argc, char** argv)
 {
@@ -98,11 +719,41 @@ main(int argc, char** argv)
     arguments.coil_file = NULL;
     arguments.probe_file = NULL;
     arguments.output_file = NULL;
+    arguments.order = QUAD_ORDER;
+    arguments.tolerance = 0;
+    arguments.kernel = SOLB_KERNEL_AGM;
+    arguments.tier = SOLB_TIER_FULL;
+    arguments.zonal = 0;
+    arguments.map = 0;
+    arguments.interp = FM_HERMITE;
+    arguments.ic = 0;
+    arguments.gradient = 0;
+    arguments.inductance = 0;
+    arguments.force = 0;
+    arguments.force_file = NULL;
+    arguments.no_mirror = 0;
+    arguments.grid = 0;
+    arguments.stream = 0;
+    arguments.resume = 0;
+    arguments.socket_path = NULL;
+    arguments.numa = 0;
+    arguments.stats = 0;
+    arguments.stats_file = NULL;
 
     argp_parse(&argp, argc, argv, 0, 0, &arguments);
 
+    /* Statistics are counted from here on, and reported however the run ends */
+    if (arguments.stats)
+    {
+        stats_path = arguments.stats_file;
+        stats_enable();
+        atexit(report_stats);
+    }
+
     /* Change to interactive mode if input files are insufficient */
-    if (arguments.coil_file == NULL || arguments.probe_file == NULL)
+    if (!arguments.interactive && (arguments.coil_file == NULL || (arguments.probe_file == NULL
+                    && !arguments.ic && !arguments.inductance && !arguments.force
+                    && !arguments.grid)))
     {
         fprintf(stderr, "No input files are detected\nChange to interactive mode");
         arguments.interactive = 1;
@@ -115,26 +766,20 @@ main(int argc, char** argv)
         return 0;
     }
 
-    /* Open the necessary file for auto-calculation */
-    FILE *c_fp = NULL;
-    if ((c_fp = fopen(arguments.coil_file, "rt")) == NULL)
-    {
-        fprintf(stderr, "%s: No such file or directory", arguments.coil_file);
-        exit(0);
-    }
+    /* Probes and fields may be binary instead; NPY files are mapped rather than read */
+    int probing = !arguments.ic && !arguments.inductance && !arguments.force;
+    int npy_in = probing && !arguments.grid && npy_detect(arguments.probe_file);
+    int npy_out = probing && arguments.output_file != NULL && npy_name(arguments.output_file);
 
-    FILE *p_fp = NULL;
-    if ((p_fp = fopen(arguments.probe_file, "rt")) == NULL)
-    {
-        fprintf(stderr, "%s: No such file or directory", arguments.probe_file);
-        exit(0);
-    }
-
-    /* Output file is optional, it is stdout by default */
+    /* Output file is optional, it is stdout by default. A resumed text output keeps its header
+     * and the rows of the probes done, and is appended to */
     FILE *o_fp = stdout;
-    if (arguments.output_file != NULL)
+    int resuming = probing && !arguments.grid && arguments.resume > 0;
+    if (arguments.output_file != NULL && !npy_out)
     {
-        if ((o_fp = fopen(arguments.output_file, "wt")) == NULL)
+        if (resuming && !text_truncate_lines(arguments.output_file, arguments.resume + 1))
+            exit(0);
+        if ((o_fp = fopen(arguments.output_file, resuming ? "at" : "wt")) == NULL)
         {
             fprintf(stderr, "%s: No such file or directory", arguments.output_file);
             exit(0);
@@ -142,276 +787,406 @@ main(int argc, char** argv)
     }
 
     /* Get coil configuration from the file */
-    std::vector<top_solenoid_t *> coils;
-    parse_coil(c_fp, &coils);
+    unsigned long long t0 = stats_now();
+    std::vector<top_solenoid_t> coils;
+    if (!text_parse_coils(arguments.coil_file, &coils))
+        exit(0);
+    stats_time(STATS_T_PARSE, t0);
     size_t ncoil = coils.size();
     if (ncoil == 0)
     {
         fprintf(stderr, "%s: No coils are properly specified", arguments.coil_file);
         exit(0);
     }
-    fclose(c_fp);
 
-    std::vector<vec2d_t> probes;
-    parse_probe(p_fp, &probes);
-    size_t nprobe = probes.size();
-    if (nprobe == 0)
+    /* Compile coils once; this validates their dimensions as well */
+    t0 = stats_now();
+    std::vector<solb_coil_t> ccoils(ncoil);
+    for (size_t j = 0; j < ncoil; ++j)
     {
-        fprintf(stderr, "%s: No probes are properly specified", arguments.probe_file);
-        exit(0);
+        if (!solb_compile(&coils[j], &ccoils[j], arguments.order)
+                || !solb_set_kernel(&ccoils[j], arguments.kernel)
+                || !solb_set_tier(&ccoils[j], arguments.tier))
+        {
+            fprintf(stderr, "%s: Coil %zu is not properly specified", arguments.coil_file, j + 1);
+            exit(0);
+        }
     }
-    fclose(p_fp);
+    stats_time(STATS_T_COMPILE, t0);
 
-    /* Run the main program
-     * We assume that typically there are more probes than coils
-     * RAM may handle 100s of millions of results, though we need to consult with the size of
-     * cache memory to optimize the performance
-     */
-    mag_field_2d_t res_chunk[CHUNK_SIZE]; 
-    size_t rem = nprobe % CHUNK_SIZE;
-    size_t full_chunks = nprobe / CHUNK_SIZE;
-    fprintf(o_fp, "%16s%16s%16s%16s\n", "Coord_R", "Coord_Z", "Br", "Bz");
-    if (full_chunks == 0)
+    /* Workers are bound to the NUMA nodes from here on, and stay so for the rest of the run */
+    numa_topo_t topo;
+    numa_topo_t *ptopo = NULL;
+    if (arguments.numa)
     {
-        for (size_t i = 0; i < nprobe; ++i)
+        if (!numa_detect(&topo) || !numa_place(&topo, omp_get_max_threads()))
+            exit(0);
+        if (arguments.verbose)
+            fprintf(stderr, "INFO: %d threads placed on %d NUMA nodes\n", topo.nthread, topo.nnode);
+        ptopo = &topo;
+    }
+
+    /* Ic check meshes the coils by itself */
+    if (arguments.ic)
+    {
+        std::vector<ic_coil_result_t> res(ncoil);
+        t0 = stats_now();
+        if (!ic_check(&ccoils[0], ncoil, &arguments.model, IC_MESH_R, IC_MESH_Z, &res[0]))
+            exit(0);
+        stats_time(STATS_T_EVAL, t0);
+        ic_print(o_fp, ncoil, &res[0]);
+        return 0;
+    }
+
+    /* Inductances need nothing but the coils either */
+    if (arguments.inductance)
+    {
+        std::vector<double> M(ncoil * ncoil);
+        t0 = stats_now();
+        if (!ind_matrix(&ccoils[0], ncoil, &M[0]))
+            exit(0);
+        stats_time(STATS_T_EVAL, t0);
+        ind_print(o_fp, &ccoils[0], ncoil, &M[0]);
+        return 0;
+    }
+
+    /* Forces are integrated over the windings as well */
+    if (arguments.force)
+    {
+        FILE *f_fp = NULL;
+        if (arguments.force_file != NULL && (f_fp = fopen(arguments.force_file, "wt")) == NULL)
         {
-            res_chunk[i].Br = 0;
-            res_chunk[i].Bz = 0;
+            fprintf(stderr, "%s: No such file or directory", arguments.force_file);
+            exit(0);
         }
-#pragma omp parallel for collapse(2)
-        for (size_t i = 0; i < nprobe; ++i)
+        std::vector<force_coil_t> res(ncoil);
+        t0 = stats_now();
+        if (!force_check(&ccoils[0], ncoil, FORCE_PANELS_R, FORCE_PANELS_Z, f_fp != NULL, &res[0]))
+            exit(0);
+        stats_time(STATS_T_EVAL, t0);
+        force_print(o_fp, ncoil, &res[0]);
+        if (f_fp != NULL)
         {
-            for (size_t j = 0; j < ncoil; ++j)
-            {
-                mag_field_2d_t res = solb_single(coils[j], probes[i].r, probes[i].z);
-                res_chunk[i].Br += res.Br;
-                res_chunk[i].Bz += res.Bz;
-            }
+            force_write(f_fp, ncoil, &res[0]);
+            fclose(f_fp);
         }
-        //fprintf(stderr, "INFO: Evaluation finished; begin writing to the result in file");
-        for (size_t i = 0; i < nprobe; ++i)
+        force_free(ncoil, &res[0]);
+        return 0;
+    }
+
+    /* Zonal harmonic expansion about the axial center of the coil set */
+    zh_expansion_t zh;
+    zh_expansion_t *pzh = NULL;
+    if (arguments.zonal > 0)
+    {
+        double zmin = ccoils[0].b1;
+        double zmax = ccoils[0].b2;
+        for (size_t j = 1; j < ncoil; ++j)
         {
-            fprintf(o_fp, "%16lf%16lf%16lf%16lf\n", probes[i].r, probes[i].z,
-                    res_chunk[i].Br, res_chunk[i].Bz);
+            zmin = ccoils[j].b1 < zmin ? ccoils[j].b1 : zmin;
+            zmax = ccoils[j].b2 > zmax ? ccoils[j].b2 : zmax;
         }
+        double tol = arguments.tolerance > 0 ? arguments.tolerance : ZH_DEFAULT_TOL;
+        t0 = stats_now();
+        if (!zh_build(&ccoils[0], ncoil, (zmin + zmax) * 0.5, arguments.zonal, tol, &zh))
+            exit(0);
+        stats_time(STATS_T_COMPILE, t0);
+        if (arguments.verbose)
+            fprintf(stderr, "INFO: Zonal expansion about z = %lf, converging within %lf, used within %lf\n",
+                    zh.z0, zh.rc, zh.rmax);
+        pzh = &zh;
     }
-    else
+
+    /* Field map; probes on it are interpolated, and all others evaluated directly */
+    fm_map_t fm;
+    fm_map_t *pfm = NULL;
+    if (arguments.map)
     {
-        for (size_t chunk = 0; chunk < full_chunks; ++chunk)
+        if (arguments.gradient || pzh != NULL || arguments.grid)
         {
-            for (size_t i = 0; i < CHUNK_SIZE; ++i)
-            {
-                res_chunk[i].Br = 0;
-                res_chunk[i].Bz = 0;
-            }
-#pragma omp parallel for collapse(2)
-            for (size_t i = 0; i < CHUNK_SIZE; ++i)
+            fprintf(stderr, "--map is not supported with --gradient, --zonal or --grid");
+            exit(0);
+        }
+        t0 = stats_now();
+        if (!fm_build(&ccoils[0], ncoil, arguments.map_r[0], arguments.map_r[1], arguments.map_z[0],
+                    arguments.map_z[1], arguments.map_nr, arguments.map_nz, &fm))
+            exit(0);
+        stats_time(STATS_T_COMPILE, t0);
+        if (arguments.verbose)
+            fprintf(stderr, "INFO: Field map of %d x %d nodes, estimated error %le T (%s)\n",
+                    fm.nr, fm.nz, fm.err_est[arguments.interp],
+                    arguments.interp == FM_LINEAR ? "linear" : "hermite");
+        pfm = &fm;
+    }
+
+    /* Structured grid; probes are never stored, and columns share their quadrature state */
+    if (arguments.grid)
+    {
+        if (arguments.gradient)
+        {
+            fprintf(stderr, "--gradient is not supported with --grid");
+            exit(0);
+        }
+        if (arguments.stream > 0)
+        {
+            fprintf(stderr, "--stream is not supported with --grid");
+            exit(0);
+        }
+        size_t nr = arguments.grid_nr;
+        size_t nz = arguments.grid_nz;
+        double dr = nr > 1 ? (arguments.grid_r[1] - arguments.grid_r[0]) / (nr - 1) : 0;
+        double dz = nz > 1 ? (arguments.grid_z[1] - arguments.grid_z[0]) / (nz - 1) : 0;
+        std::vector<double> z(nz);
+        for (size_t k = 0; k < nz; ++k)
+            z[k] = arguments.grid_z[0] + dz * k;
+
+        /* Mirror symmetry; in a grid symmetric about the plane of the coils, every column
+         * takes the field of the symmetric coils at the z of one half from the other */
+        column_mirror_t mir;
+        const column_mirror_t *pmir = NULL;
+        std::vector<long> partner(ncoil);
+        double zc = 0;
+        size_t nsym = (pzh != NULL || arguments.no_mirror) ? 0
+            : mirror_coils(&ccoils[0], ncoil, &zc, &partner[0]);
+        if (nsym > 0)
+        {
+            std::vector<double> raxis(nz, 0.0);
+            mir.src.resize(nz);
+            size_t nprim = mirror_probes(raxis.data(), z.data(), nz, zc, &mir.src[0]);
+            if (nprim < nz)
             {
                 for (size_t j = 0; j < ncoil; ++j)
+                    (partner[j] >= 0 ? mir.symc : mir.rest).push_back(ccoils[j]);
+                mir.slot.resize(nz);
+                for (size_t k = 0; k < nz; ++k)
                 {
-                    mag_field_2d_t res = solb_single(coils[j],
-                            probes[i + CHUNK_SIZE * chunk].r,
-                            probes[i + CHUNK_SIZE * chunk].z);
-                    res_chunk[i].Br += res.Br;
-                    res_chunk[i].Bz += res.Bz;
+                    if (mir.src[k] == k)
+                    {
+                        mir.slot[k] = mir.zprim.size();
+                        mir.zprim.push_back(z[k]);
+                    }
                 }
+                pmir = &mir;
             }
-            for (size_t i = 0; i < CHUNK_SIZE; ++i)
-            {
-                fprintf(o_fp, "%16lf%16lf%16lf%16lf\n",
-                        probes[i + CHUNK_SIZE * chunk].r,
-                        probes[i + CHUNK_SIZE * chunk].z,
-                        res_chunk[i].Br, res_chunk[i].Bz);
-            }
-        }
-        for (size_t i = 0; i < rem; ++i)
-        {
-            res_chunk[i].Br = 0;
-            res_chunk[i].Bz = 0;
+            if (arguments.verbose)
+                fprintf(stderr, "INFO: %zu of %zu coils and %zu of %zu grid rows are mirrored about z = %lf\n",
+                        nsym, ncoil, nz - nprim, nz, zc);
         }
-#pragma omp parallel for collapse(2)
-        for (size_t i = 0; i < rem; ++i)
+
+        /* Binary output is written by every column in place */
+        if (npy_out)
         {
-            for (size_t j = 0; j < ncoil; ++j)
+            npy_map_t out;
+            size_t n = nr * nz;
+            if (!npy_create(arguments.output_file, 4, n, &out))
+                exit(0);
+#pragma omp parallel for schedule(dynamic)
+            for (long c = 0; c < (long)nr; ++c)
             {
-                mag_field_2d_t res = solb_single(coils[j],
-                        probes[i + CHUNK_SIZE * full_chunks].r,
-                        probes[i + CHUNK_SIZE * full_chunks].z);
-                res_chunk[i].Br += res.Br;
-                res_chunk[i].Bz += res.Bz;
+                double r = arguments.grid_r[0] + dr * c;
+                for (size_t k = 0; k < nz; ++k)
+                {
+                    out.data[c * nz + k] = r;
+                    out.data[n + c * nz + k] = z[k];
+                }
+                unsigned long long tc = stats_now();
+                eval_grid_column(r, z.data(), nz, out.data + 2 * n + c * nz,
+                        out.data + 3 * n + c * nz, ccoils, arguments.tolerance, pzh, pmir);
+                stats_time(STATS_T_EVAL, tc);
             }
+            npy_close(&out);
+            return 0;
         }
-        for (size_t i = 0; i < rem; ++i)
-        {
-            fprintf(o_fp, "%16lf%16lf%16lf%16lf\n",
-                    probes[i + CHUNK_SIZE * full_chunks].r,
-                    probes[i + CHUNK_SIZE * full_chunks].z,
-                    res_chunk[i].Br, res_chunk[i].Bz);
-        }
-    }
 
+        grid_job_t job = { arguments.grid_r[0], dr, z.data(), nz, &ccoils, arguments.tolerance,
+            pzh, pmir };
+        fprintf(o_fp, "%16s%16s%16s%16s\n", "Coord_R", "Coord_Z", "Br", "Bz");
+        if (!text_pipe(o_fp, nr, write_column, &job))
+            exit(0);
+        return 0;
+    }
 
-    return 0;
-}
-
-/*
- * parse_coil
- * Parse coils from the coil configuration input file.
- * returns 1 on success, 0 on failure
- */
-int
-parse_coil(FILE *coil_fp, std::vector<top_solenoid_t *> *coils)
-{
-    top_solenoid_t sol;
-    char buf[BUF_SIZE];
-    while (fgets(buf, BUF_SIZE, coil_fp) != NULL)
+    /* Probe sets larger than memory */
+    if (arguments.stream > 0)
     {
-        if (!parse_single_coil(buf, &sol))
-            return 0;
-        top_solenoid_t *item = new top_solenoid_t(&sol);
-        std::vector<top_solenoid_t *>::iterator it = coils->end();
-        coils->insert(it, item);
+        run_stream(&arguments, ccoils, pzh, pfm, ptopo, npy_in, npy_out, o_fp);
+        return 0;
     }
-    return 1;
-}
 
-/*
- * parse_single_coil
- * Parse a single line of coil configuration file into solenoid data.
- * returns 1 on success, 0 on failure
- */
-int
-parse_single_coil(char *str, top_solenoid_t *sol)
-{
-    static const char* label = "parse_single_coil";
-
-    char *tok;
-    double base;
-    char de;
-    int exponent;
+    /* Probes as rows of r and z; binary files are mapped, and text files are parsed in
+     * parallel */
+    npy_map_t in;
+    in.base = NULL;
+    std::vector<double> probe_r;
+    std::vector<double> probe_z;
+    const double *pr;
+    const double *pz;
+    size_t nprobe;
+    t0 = stats_now();
+    if (npy_in)
+    {
+        if (!npy_open(arguments.probe_file, 2, 0, &in))
+            exit(0);
+        nprobe = in.n;
+        pr = in.data;
+        pz = in.data + nprobe;
+    }
+    else
+    {
+        if (!text_parse_probes(arguments.probe_file, &probe_r, &probe_z))
+            exit(0);
+        nprobe = probe_r.size();
+        pr = probe_r.data();
+        pz = probe_z.data();
+    }
+    stats_time(STATS_T_PARSE, t0);
+    if (nprobe == 0)
+    {
+        fprintf(stderr, "%s: No probes are properly specified", arguments.probe_file);
+        exit(0);
+    }
 
-    int idx = 0;
-    tok = strtok(str, " \t\r\n");
-    while (tok != NULL)
+    /* Binary output; probes are evaluated as arrays, and results go straight into the output
+     * map, rows of r, z, Br, Bz and the Jacobian if asked for. Mirror symmetry is not
+     * exploited here */
+    if (npy_out)
     {
-        /* Parse fortran/matlab like floats as well as c-type floats */
-        int res = sscanf(tok, "%lf%c%d", &base, &de, &exponent);
-        switch (res)
+        size_t rows = arguments.gradient ? 8 : 4;
+        npy_map_t out;
+        if (!npy_create(arguments.output_file, rows, nprobe, &out))
+            exit(0);
+        double *r = out.data;
+        double *z = out.data + nprobe;
+        double *res[6];
+        for (size_t k = 0; k < rows - 2; ++k)
+            res[k] = out.data + (k + 2) * nprobe;
+        tile_job_t tile;
+        tile_init(&tile, &ccoils[0], ncoil, pzh, arguments.tolerance, arguments.gradient, nprobe);
+        if (pfm != NULL)
+            tile_map(&tile, pfm, arguments.interp);
+        if (ptopo != NULL)
+            tile_touch_numa(&tile, ptopo, pr, pz, r, z, res);
+        else
         {
-            case 0:
-                fprintf(stderr, "%s: Wrong floating point expression in the file, try %%lf[d|D|e|E]%%d", label);
-                return 0;
-            case 1:
-                exponent = 3;
-                break;
-            case 2:
-                exponent = 3;
-            case 3:
-                if (de != 'e' && de != 'E' && de != 'd' && de != 'D')
-                {
-                    fprintf(stderr, "%s: Wrong floating point expression in the file, try %%lf[d|D|e|E]%%d", label);
-                    return 0;
-                }
-                break;
-            default:
-                fprintf(stderr, "%s: Unknown error from sscanf", label);
-                return 0;
+            memcpy(r, pr, nprobe * sizeof(double));
+            memcpy(z, pz, nprobe * sizeof(double));
         }
-        switch (idx)
+        npy_close(&in);
+        t0 = stats_now();
+        tile_eval_numa(&tile, ptopo, r, z, res);
+        stats_time(STATS_T_EVAL, t0);
+        npy_close(&out);
+        return 0;
+    }
+
+    /* Mirror symmetry; probes whose image is also a probe take the field of the symmetric
+     * coils from their image, and only the others are evaluated for them */
+    std::vector<long> partner(ncoil);
+    double zc = 0;
+    size_t nsym = (pzh != NULL || pfm != NULL || arguments.no_mirror || arguments.gradient) ? 0
+        : mirror_coils(&ccoils[0], ncoil, &zc, &partner[0]);
+    std::vector<size_t> src(nsym > 0 ? nprobe : 0);
+    size_t nprim = nsym > 0 ? mirror_probes(pr, pz, nprobe, zc, &src[0]) : nprobe;
+    if (arguments.verbose && nsym > 0)
+        fprintf(stderr, "INFO: %zu of %zu coils and %zu of %zu probes are mirrored about z = %lf\n",
+                nsym, ncoil, nprobe - nprim, nprobe, zc);
+    if (nprim < nprobe)
+    {
+        std::vector<solb_coil_t> symc;
+        std::vector<solb_coil_t> rest;
+        for (size_t j = 0; j < ncoil; ++j)
+            (partner[j] >= 0 ? symc : rest).push_back(ccoils[j]);
+
+        std::vector<double> prim(2 * nprim);
+        std::vector<size_t> slot(nprobe);
+        std::vector<unsigned char> flip(nprobe);
+        for (size_t i = 0, k = 0; i < nprobe; ++i)
         {
-            case 0:
-            case 1:
-            case 2:
-            case 3:
-                /* Coil dimension in mm; should be translated into m */
-                if (exponent != 3)
-                    base *= pow(10, exponent - 3);
-                break;
-            case 4:
-                /* Current density is given in A/mm^2; should be translated into SI units */
-                if (exponent != -6)
-                    base *= pow(10, exponent + 6);
-                break;
-            default:
-                fprintf(stderr, "%s: Wrong number of coil parameters", label);
-                return 0;
+            flip[i] = src[i] != i;
+            if (src[i] == i)
+            {
+                slot[i] = k;
+                prim[k] = pr[i];
+                prim[nprim + k] = pz[i];
+                ++k;
+            }
         }
-        switch (idx)
+        std::vector<double> res(2 * nprim + (rest.empty() ? 0 : 2 * nprobe));
+        double *res_prim[2] = { &res[0], &res[nprim] };
+        double *res_rest[2] = { &res[2 * nprim], &res[2 * nprim + nprobe] };
+        tile_job_t tile;
+        t0 = stats_now();
+        tile_init(&tile, &symc[0], symc.size(), NULL, arguments.tolerance, 0, nprim);
+        tile_eval_numa(&tile, ptopo, &prim[0], &prim[nprim], res_prim);
+        if (!rest.empty())
         {
-            case 0:
-                sol->a1 = base;
-                break;
-            case 1:
-                sol->a2 = base;
-                break;
-            case 2:
-                sol->b1 = base;
-                break;
-            case 3:
-                sol->b2 = base;
-                break;
-            case 4:
-                sol->j = base;
-                break;
+            tile_init(&tile, &rest[0], rest.size(), NULL, arguments.tolerance, 0, nprobe);
+            tile_eval_numa(&tile, ptopo, pr, pz, res_rest);
         }
-        tok = strtok(NULL, " \t\r\n");
-        ++idx;
+        stats_time(STATS_T_EVAL, t0);
+
+        mirror_job_t job = { pr, pz, nprobe, src.data(), slot.data(), flip.data(), res_prim,
+            rest.empty() ? NULL : res_rest };
+        fprintf(o_fp, "%16s%16s%16s%16s\n", "Coord_R", "Coord_Z", "Br", "Bz");
+        if (!text_pipe(o_fp, (nprobe + ARRAY_CHUNK - 1) / ARRAY_CHUNK, write_mirrored, &job))
+            exit(0);
+        return 0;
     }
-    return 1;
-}
 
-/*
- * parse_probe
- * Parse probes from the probe configuration input file.
- * returns 1 on success, 0 on failure
- */
-int
-parse_probe(FILE *probe_fp, std::vector<vec2d_t> *probes)
-{
-    vec2d_t probe;
-    char buf[BUF_SIZE];
-    while (fgets(buf, BUF_SIZE, probe_fp) != NULL)
+    /* Run the main program
+     * Every worker evaluates and formats tiles of probes on its own, while a writer thread
+     * puts finished tiles on the disk in order. Runs too small to keep every core busy that
+     * way split the coils as well, and are evaluated ahead of the output. So are runs placed on
+     * the NUMA nodes, from copies of the probes first touched by the node of each tile
+     */
+    tile_job_t tile;
+    tile_init(&tile, &ccoils[0], ncoil, pzh, arguments.tolerance, arguments.gradient, nprobe);
+    if (pfm != NULL)
+        tile_map(&tile, pfm, arguments.interp);
+    int nout = tile_outputs(&tile);
+    int ahead = tile.ngroup > 1 || ptopo != NULL;
+    std::vector<double> buf(tile.ngroup > 1 && ptopo == NULL ? nout * nprobe : 0);
+    double *local = NULL;
+    double *res[6];
+    for (int k = 0; k < nout; ++k)
+        res[k] = tile.ngroup > 1 && ptopo == NULL ? &buf[k * nprobe] : NULL;
+    if (ptopo != NULL)
     {
-        if (sscanf(buf, "%lf%lf", &probe.r, &probe.z) != 2)
-            return 0;
-        vec2d_t *item = new vec2d_t(&probe);
-        std::vector<vec2d_t>::iterator it = probes->end();
-        probes->insert(it, item);
+        if ((local = numa_array((2 + nout) * nprobe)) == NULL)
+            exit(0);
+        for (int k = 0; k < nout; ++k)
+            res[k] = local + (2 + k) * nprobe;
+        tile_touch_numa(&tile, ptopo, pr, pz, local, local + nprobe, res);
+        pr = local;
+        pz = local + nprobe;
     }
-    return 1;
+    if (ahead)
+    {
+        t0 = stats_now();
+        tile_eval_numa(&tile, ptopo, pr, pz, res);
+        stats_time(STATS_T_EVAL, t0);
+    }
+    probe_job_t job = { pr, pz, &tile, ahead ? res : NULL };
+    write_header(o_fp, arguments.gradient);
+    if (!text_pipe(o_fp, tile.ntile, write_probes, &job))
+        exit(0);
+    numa_array_free(local, (2 + nout) * nprobe);
+    npy_close(&in);
+
+    return 0;
 }
 
 /*
  * run_interactive
- * Run in interactive mode.
- * TODO
+ * Run in interactive mode; a daemon keeps the coil sets loaded and answers probe requests
+ * until its clients are done.
  */
 void
 run_interactive(struct arguments *arguments)
 {
-    /* Initial setup */
-    FILE *c_fp = NULL;
-    FILE *p_fp = NULL;
-    if (arguments->coil_file != NULL)
-    {
-        if ((c_fp = fopen(arguments->coil_file, "rt")) == NULL)
-        {
-            fprintf(stderr, "%s: No such file or directory", arguments->coil_file);
-            return;
-        }
-    }
-    if (arguments->probe_file != NULL)
-    {
-        if ((p_fp = fopen(arguments->probe_file, "rt")) == NULL)
-        {
-            fprintf(stderr, "%s: No such file or directory", arguments->probe_file);
-            return;
-        }
-    }
-
     /* In the interactive mode, output file saves the entire log, though it is
      * optional */
-    FILE *o_fp = stdout;
+    FILE *o_fp = NULL;
     if (arguments->output_file != NULL)
     {
         if ((o_fp = fopen(arguments->output_file, "wt")) == NULL)
@@ -421,15 +1196,14 @@ run_interactive(struct arguments *arguments)
         }
     }
 
-    /* Buffers and other stuffs for interactive calculation */
-    //char buf[BUF_SIZE];
-
-    /* Interactive loop */
-    // TODO Use bison/yacc
-    while (1)
-    {
-        break;
-
-    }
-    return;
+    daemon_conf_t conf;
+    conf.order = arguments->order;
+    conf.kernel = arguments->kernel;
+    conf.tier = arguments->tier;
+    conf.tol = arguments->tolerance;
+    conf.grad = arguments->gradient;
+    conf.log = o_fp;
+    daemon_run(&conf, arguments->coil_file, arguments->socket_path);
+    if (o_fp != NULL)
+        fclose(o_fp);
 }
@@ -0,0 +1,371 @@
+/**
+ * bench-main.cpp
+ *
+ * Benchmark of the field evaluation. Probes are drawn from five regions of
+ * the 8-coil magnet of build/coil.txt: the axis, the 20 cm DSV, a 1 cm
+ * shell around the windings, the windings themselves and the far field.
+ * Every region is timed for coil sets of 1, 8 and 64 coils (the magnet cut
+ * into axial slices, same field), for several batch sizes and thread
+ * counts, through the tiled evaluation of the application.
+ *
+ * A sample repeats calls of one batch until it lasts --min-time, and gives
+ * ns/query; a configuration takes --samples samples after a warm-up call,
+ * and reports their mean with a 95% confidence interval of Student's t.
+ * Results are printed as a table, and written as JSON with --json so that
+ * runs of different versions can be compared.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <argp.h>
+#include <unistd.h>
+#include <omp.h>
+
+#include "../core/solb.h"
+#include "../tile/tile-sched.h"
+
+#define BENCH_POOL 65536 // Probes drawn per region; batches cycle through them
+#define BENCH_SAMPLES 10 // Samples per configuration
+#define BENCH_MIN_TIME 0.05 // Shortest sample, in seconds
+#define BENCH_SLICES 8 // Axial slices per coil of the 64-coil set
+
+static const char *bench_regions[] = { "axis", "dsv", "near", "inside", "far" };
+#define BENCH_NREGION 5
+static const int bench_coils[] = { 1, 8, 8 * BENCH_SLICES };
+#define BENCH_NCOILS 3
+static const size_t bench_batches[] = { 1, 16, 256, 4096 };
+#define BENCH_NBATCH 4
+
+/* The 8-coil magnet of build/coil.txt in m and A/m^2. */
+static const double bench_magnet[8][5] = {
+	{ .5, .5228, -.1974, .1974, 4.761905e8 },
+	{ .5, .5140, -.0672, .0672, -4.761905e8 },
+	{ .5, .5050, .0672, .1932, -4.761905e8 },
+	{ .5, .5050, -.1932, -.0672, -4.761905e8 },
+	{ .5, .5080, .1974, .4054, 3.846154e8 },
+	{ .5, .5080, -.4054, -.1974, 3.846154e8 },
+	{ .5, .5320, .4054, .7774, 3.225806e8 },
+	{ .5, .5320, -.7774, -.4054, 3.225806e8 }
+};
+
+const char *argp_program_version = "bench 1.0";
+
+static char doc[] =
+	"bench -- Throughput of the field evaluation by region, coil count, batch size and thread count.";
+
+static struct argp_option options[] = {
+	{ "json",		'j', "FILE",	0, "Write the results as JSON to FILE" },
+	{ "threads",	't', "LIST",	0, "Comma-separated thread counts (default 1 and every core)" },
+	{ "samples",	's', "N",		0, "Samples per configuration (default 10)" },
+	{ "min-time",	'm', "SEC",		0, "Shortest sample in seconds (default 0.05)" },
+	{ "kernel",		'k', "NAME",	0, "Elliptic integral kernel; agm (default) or carlson" },
+	{ "accuracy",	'a', "TIER",	0, "Accuracy tier; full (default), ppb, ppm, single or fine" },
+	{ 0 }
+};
+
+struct arguments
+{
+	char *json_file;
+	std::vector<int> threads;
+	int samples;
+	double min_time;
+	int kernel;
+	int tier;
+};
+
+static error_t
+parse_opt(int key, char *arg, struct argp_state *state)
+{
+	struct arguments *arguments = (struct arguments *)state->input;
+	switch (key)
+	{
+		case 'j':
+			arguments->json_file = arg;
+			break;
+		case 't':
+		{
+			arguments->threads.clear();
+			char *save = NULL;
+			for (char *tok = strtok_r(arg, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save))
+			{
+				int t = atoi(tok);
+				if (t < 1)
+					argp_error(state, "Wrong thread count %s", tok);
+				arguments->threads.push_back(t);
+			}
+			break;
+		}
+		case 's':
+			arguments->samples = atoi(arg);
+			if (arguments->samples < 2)
+				argp_error(state, "At least 2 samples are needed");
+			break;
+		case 'm':
+			arguments->min_time = atof(arg);
+			break;
+		case 'k':
+			if (strcmp(arg, "agm") == 0)
+				arguments->kernel = SOLB_KERNEL_AGM;
+			else if (strcmp(arg, "carlson") == 0)
+				arguments->kernel = SOLB_KERNEL_CARLSON;
+			else
+				argp_error(state, "Unknown kernel %s", arg);
+			break;
+		case 'a':
+			if ((arguments->tier = solb_tier_parse(arg)) < 0)
+				argp_error(state, "Unknown accuracy tier %s", arg);
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	options,
+	parse_opt,
+	0,
+	doc
+};
+
+/* Statistics of a configuration, in ns/query. */
+typedef struct _bench_stat_t
+{
+	double mean;
+	double sd;
+	double lo;				/* 95% confidence interval of the mean */
+	double hi;
+	size_t queries;			/* Queries timed over every sample */
+} bench_stat_t;
+
+/* Two-sided 95% quantile of Student's t with dof degrees of freedom. */
+static double
+bench_t95(int dof)
+{
+	static const double t[30] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	return dof <= 30 ? t[dof - 1] : 1.960;
+}
+
+/* Coil set of ncoil coils: the first coil of the magnet, the magnet, or the
+ * magnet cut into BENCH_SLICES axial slices per coil. */
+static void
+bench_coil_set(int ncoil, std::vector<solb_coil_t> *coils)
+{
+	int nmag = ncoil == 1 ? 1 : 8;
+	int nslice = ncoil / nmag;
+	coils->resize(ncoil);
+	for (int j = 0; j < nmag; ++j)
+	{
+		const double *s = bench_magnet[j];
+		double dz = (s[3] - s[2]) / nslice;
+		for (int k = 0; k < nslice; ++k)
+		{
+			top_solenoid_t sol(s[0], s[1], s[2] + dz * k, s[2] + dz * (k + 1), s[4]);
+			solb_compile(&sol, &(*coils)[j * nslice + k]);
+		}
+	}
+}
+
+/* Fraction in [0, 1) of a probe index and a salt; a fixed scatter, so that
+ * every run times the same probes. */
+static double
+bench_frac(size_t i, unsigned salt)
+{
+	unsigned h = (unsigned)i * 2654435761u + salt * 40503u;
+	h ^= h >> 15;
+	h *= 2246822519u;
+	h ^= h >> 13;
+	return (h & 0xffffff) / 16777216.0;
+}
+
+/* BENCH_POOL probes of a region of the magnet. */
+static void
+bench_probes(int region, double *r, double *z)
+{
+	for (size_t i = 0; i < BENCH_POOL; ++i)
+	{
+		double u = bench_frac(i, 1);
+		double v = bench_frac(i, 2);
+		const double *s = bench_magnet[i % 8];
+		switch (region)
+		{
+			case 0:
+				/* Axis over the length of the magnet */
+				r[i] = 0;
+				z[i] = -.7774 + 2 * .7774 * u;
+				break;
+			case 1:
+			{
+				/* Uniform in the 20 cm sphere */
+				double rho = .2 * cbrt(u);
+				double ct = 2 * v - 1;
+				r[i] = rho * sqrt(1 - ct * ct);
+				z[i] = rho * ct;
+				break;
+			}
+			case 2:
+				/* Within 1 cm of the bore or the outer face of a winding */
+				r[i] = i % 2 ? s[0] - .01 * u : s[1] + .01 * u;
+				z[i] = s[2] + (s[3] - s[2]) * v;
+				break;
+			case 3:
+				/* Inside a winding */
+				r[i] = s[0] + (s[1] - s[0]) * u;
+				z[i] = s[2] + (s[3] - s[2]) * v;
+				break;
+			default:
+				/* 2 to 10 m off the center */
+				r[i] = (2 + 8 * u) * sqrt(v);
+				z[i] = (2 + 8 * u) * sqrt(1 - v) * (i % 2 ? 1 : -1);
+				break;
+		}
+	}
+}
+
+/* Time a configuration; calls evaluate batch probes at a time, taken in
+ * turn from the pool. */
+static void
+bench_run(const std::vector<solb_coil_t> &coils, const double *r, const double *z,
+		size_t batch, int samples, double min_time, bench_stat_t *st)
+{
+	std::vector<double> res(2 * batch);
+	double *out[2] = { &res[0], &res[batch] };
+	size_t off = 0;
+	tile_job_t tile;
+	tile_init(&tile, coils.data(), coils.size(), NULL, 0, 0, batch);
+	tile_eval(&tile, r, z, out);
+
+	std::vector<double> ns(samples);
+	st->queries = 0;
+	for (int s = 0; s < samples; ++s)
+	{
+		size_t calls = 0;
+		double elapsed;
+		double begin = omp_get_wtime();
+		do
+		{
+			tile_init(&tile, coils.data(), coils.size(), NULL, 0, 0, batch);
+			tile_eval(&tile, r + off, z + off, out);
+			off = off + 2 * batch <= BENCH_POOL ? off + batch : 0;
+			++calls;
+		} while ((elapsed = omp_get_wtime() - begin) < min_time);
+		ns[s] = elapsed * 1e9 / (calls * batch);
+		st->queries += calls * batch;
+	}
+
+	double sum = 0;
+	for (int s = 0; s < samples; ++s)
+		sum += ns[s];
+	st->mean = sum / samples;
+	double var = 0;
+	for (int s = 0; s < samples; ++s)
+		var += (ns[s] - st->mean) * (ns[s] - st->mean);
+	st->sd = sqrt(var / (samples - 1));
+	double half = bench_t95(samples - 1) * st->sd / sqrt((double)samples);
+	st->lo = st->mean - half;
+	st->hi = st->mean + half;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct arguments arguments;
+	arguments.json_file = NULL;
+	arguments.samples = BENCH_SAMPLES;
+	arguments.min_time = BENCH_MIN_TIME;
+	arguments.kernel = SOLB_KERNEL_AGM;
+	arguments.tier = SOLB_TIER_FULL;
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+	int maxthreads = omp_get_max_threads();
+	if (arguments.threads.empty())
+	{
+		arguments.threads.push_back(1);
+		if (maxthreads > 1)
+			arguments.threads.push_back(maxthreads);
+	}
+
+	FILE *j_fp = NULL;
+	if (arguments.json_file != NULL && (j_fp = fopen(arguments.json_file, "wt")) == NULL)
+	{
+		fprintf(stderr, "%s: No such file or directory", arguments.json_file);
+		exit(0);
+	}
+
+	char host[256] = "unknown";
+	gethostname(host, sizeof(host) - 1);
+	time_t now = time(NULL);
+	char date[32];
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+	if (j_fp != NULL)
+	{
+		fprintf(j_fp, "{\n  \"program\": \"%s\",\n  \"date\": \"%s\",\n  \"host\": \"%s\",\n",
+				argp_program_version, date, host);
+		fprintf(j_fp, "  \"backend\": \"%s\",\n  \"kernel\": \"%s\",\n  \"tier\": \"%s\",\n  \"order\": %d,\n",
+				VM_BACKEND, arguments.kernel == SOLB_KERNEL_CARLSON ? "carlson" : "agm",
+				solb_tier_name(arguments.tier), QUAD_ORDER);
+		fprintf(j_fp, "  \"cpus\": %d,\n  \"samples\": %d,\n  \"min_time\": %g,\n  \"results\": [",
+				maxthreads, arguments.samples, arguments.min_time);
+	}
+
+	printf("%-8s%8s%8s%8s%14s%24s%14s\n", "Region", "Coils", "Batch", "Threads", "ns/query",
+			"95% CI", "queries/s");
+	std::vector<double> r(BENCH_POOL);
+	std::vector<double> z(BENCH_POOL);
+	int first = 1;
+	for (int g = 0; g < BENCH_NREGION; ++g)
+	{
+		bench_probes(g, r.data(), z.data());
+		for (int c = 0; c < BENCH_NCOILS; ++c)
+		{
+			std::vector<solb_coil_t> coils;
+			bench_coil_set(bench_coils[c], &coils);
+			for (size_t j = 0; j < coils.size(); ++j)
+			{
+				solb_set_kernel(&coils[j], arguments.kernel);
+				solb_set_tier(&coils[j], arguments.tier);
+			}
+			for (int b = 0; b < BENCH_NBATCH; ++b)
+			{
+				for (size_t t = 0; t < arguments.threads.size(); ++t)
+				{
+					omp_set_num_threads(arguments.threads[t]);
+					bench_stat_t st;
+					bench_run(coils, r.data(), z.data(), bench_batches[b], arguments.samples,
+							arguments.min_time, &st);
+					printf("%-8s%8d%8zu%8d%14.1lf      [%8.1lf, %8.1lf]%14.0lf\n",
+							bench_regions[g], bench_coils[c], bench_batches[b],
+							arguments.threads[t], st.mean, st.lo, st.hi, 1e9 / st.mean);
+					fflush(stdout);
+					if (j_fp != NULL)
+					{
+						fprintf(j_fp, "%s\n    { \"region\": \"%s\", \"coils\": %d, \"batch\": %zu, "
+								"\"threads\": %d, \"queries\": %zu,\n"
+								"      \"ns_per_query\": { \"mean\": %.4g, \"sd\": %.4g, "
+								"\"ci95\": [%.4g, %.4g] },\n"
+								"      \"queries_per_s\": { \"mean\": %.6g, \"ci95\": [%.6g, %.6g] } }",
+								first ? "" : ",", bench_regions[g], bench_coils[c], bench_batches[b],
+								arguments.threads[t], st.queries, st.mean, st.sd, st.lo, st.hi,
+								1e9 / st.mean, 1e9 / st.hi, st.lo > 0 ? 1e9 / st.lo : 0.0);
+						first = 0;
+					}
+				}
+			}
+		}
+	}
+	omp_set_num_threads(maxthreads);
+
+	if (j_fp != NULL)
+	{
+		fprintf(j_fp, "\n  ]\n}\n");
+		fclose(j_fp);
+	}
+	return 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * fieldmap.cpp
+ *
+ * Field map of a fixed coil set. Grid nodes are sampled with the Jacobian of
+ * the field by the gradient kernel of every coil; only the cross derivatives
+ * come from fourth order finite differences, along r, of the sampled dB/dz,
+ * which matches the order of bicubic Hermite interpolation. The derivatives
+ * jump across the edges of a winding, and are singular at its corners, so a
+ * map keeps clear of every winding. The error of each mode is estimated by
+ * the largest error found at the centers of all cells, where the
+ * interpolants are farthest from their nodes; it is sampled, not bounded.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <vector>
+
+#include "fieldmap.h"
+
+/* Node (i, j) of the map, i along r and j along z. */
+static inline fm_node_t *
+fm_node(const fm_map_t *fm, int i, int j)
+{
+	size_t tile = (size_t)(j / FM_TILE) * fm->tr + i / FM_TILE;
+	return fm->nodes + (tile * FM_TILE + j % FM_TILE) * FM_TILE + i % FM_TILE;
+}
+
+/* Fourth order finite difference of n >= FM_MIN_NODES samples at the given
+ * stride; one-sided stencils of the same order at both ends. */
+static void
+fm_diff(const double *f, int n, size_t stride, double h, double *d)
+{
+	double c = 1 / (12 * h);
+#define F(k) f[(size_t)(k) * stride]
+#define D(k) d[(size_t)(k) * stride]
+	D(0) = (-25 * F(0) + 48 * F(1) - 36 * F(2) + 16 * F(3) - 3 * F(4)) * c;
+	D(1) = (-3 * F(0) - 10 * F(1) + 18 * F(2) - 6 * F(3) + F(4)) * c;
+	for (int k = 2; k < n - 2; ++k)
+		D(k) = (F(k - 2) - 8 * F(k - 1) + 8 * F(k + 1) - F(k + 2)) * c;
+	D(n - 2) = (3 * F(n - 1) + 10 * F(n - 2) - 18 * F(n - 3) + 6 * F(n - 4)
+			- F(n - 5)) * c;
+	D(n - 1) = (25 * F(n - 1) - 48 * F(n - 2) + 36 * F(n - 3) - 16 * F(n - 4)
+			+ 3 * F(n - 5)) * c;
+#undef F
+#undef D
+}
+
+/* Direct field of every coil at n probes. */
+static void
+fm_direct(const fm_map_t *fm, const double *r, const double *z, size_t n,
+		double *Br, double *Bz)
+{
+	std::vector<double> buf(2 * n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		Br[i] = 0;
+		Bz[i] = 0;
+	}
+	for (size_t j = 0; j < fm->ncoil; ++j)
+	{
+		solb_eval_batch(&fm->coils[j], r, z, n, &buf[0], &buf[n]);
+		for (size_t i = 0; i < n; ++i)
+		{
+			Br[i] += buf[i];
+			Bz[i] += buf[n + i];
+		}
+	}
+}
+
+/* Interpolation within the map. */
+static inline mag_field_2d_t
+fm_interp(const fm_map_t *fm, double r, double z, int mode)
+{
+	double u = (r - fm->r0) / fm->dr;
+	double v = (z - fm->z0) / fm->dz;
+	int i = (int)u;
+	int j = (int)v;
+	i = i > fm->nr - 2 ? fm->nr - 2 : i;
+	j = j > fm->nz - 2 ? fm->nz - 2 : j;
+	u -= i;
+	v -= j;
+
+	const fm_node_t *n00 = fm_node(fm, i, j);
+	const fm_node_t *n10 = fm_node(fm, i + 1, j);
+	const fm_node_t *n01 = fm_node(fm, i, j + 1);
+	const fm_node_t *n11 = fm_node(fm, i + 1, j + 1);
+
+	if (mode == FM_LINEAR)
+	{
+		double w00 = (1 - u) * (1 - v);
+		double w10 = u * (1 - v);
+		double w01 = (1 - u) * v;
+		double w11 = u * v;
+
+		mag_field_2d_t B{
+			w00 * n00->Br + w10 * n10->Br + w01 * n01->Br + w11 * n11->Br,
+			w00 * n00->Bz + w10 * n10->Bz + w01 * n01->Bz + w11 * n11->Bz};
+
+		return B;
+	}
+
+	/* Cubic Hermite basis of both directions; derivative terms are scaled
+	 * to the unit cell. */
+	double u2 = u * u;
+	double v2 = v * v;
+	double hu[4] = { 2 * u2 * u - 3 * u2 + 1, -2 * u2 * u + 3 * u2,
+		(u2 * u - 2 * u2 + u) * fm->dr, (u2 * u - u2) * fm->dr };
+	double hv[4] = { 2 * v2 * v - 3 * v2 + 1, -2 * v2 * v + 3 * v2,
+		(v2 * v - 2 * v2 + v) * fm->dz, (v2 * v - v2) * fm->dz };
+
+	double Br = 0;
+	double Bz = 0;
+	const fm_node_t *c[2][2] = { { n00, n01 }, { n10, n11 } };
+	for (int a = 0; a < 2; ++a)
+	{
+		for (int b = 0; b < 2; ++b)
+		{
+			const fm_node_t *p = c[a][b];
+			double w0 = hu[a] * hv[b];
+			double wr = hu[2 + a] * hv[b];
+			double wz = hu[a] * hv[2 + b];
+			double wrz = hu[2 + a] * hv[2 + b];
+			Br += w0 * p->Br + wr * p->Br_r + wz * p->Br_z + wrz * p->Br_rz;
+			Bz += w0 * p->Bz + wr * p->Bz_r + wz * p->Bz_z + wrz * p->Bz_rz;
+		}
+	}
+
+	mag_field_2d_t B{Br, Bz};
+
+	return B;
+}
+
+/*
+ * fm_build
+ * Sample the field of compiled coils on nr x nz nodes over [r0, r1] x
+ * [z0, z1] and estimate the error of both interpolation modes. The map must
+ * neither overlap nor touch the cross-section of any winding. Coils are
+ * kept by reference for the direct evaluation off the map.
+ * returns 1 on success, 0 on failure
+ */
+int
+fm_build(const solb_coil_t *coils, size_t ncoil, double r0, double r1,
+		double z0, double z1, int nr, int nz, fm_map_t *fm)
+{
+	static const char *label = "fm_build";
+
+	/* Handle bad inputs. */
+	if (coils == NULL || ncoil == 0)
+	{
+		fprintf(stderr, "%s: No solenoid has been specified.", label);
+		return 0;
+	}
+	if (nr < FM_MIN_NODES || nz < FM_MIN_NODES)
+	{
+		fprintf(stderr, "%s: The map needs at least %d nodes per direction.",
+				label, FM_MIN_NODES);
+		return 0;
+	}
+	if (r0 < 0 || !(r1 > r0) || !(z1 > z0))
+	{
+		fprintf(stderr, "%s: Wrong map dimension.", label);
+		return 0;
+	}
+	for (size_t c = 0; c < ncoil; ++c)
+	{
+		if (coils[c].a1 <= r1 && coils[c].a2 >= r0
+				&& coils[c].b1 <= z1 && coils[c].b2 >= z0)
+		{
+			fprintf(stderr, "%s: The map meets the winding of coil %zu.",
+					label, c + 1);
+			return 0;
+		}
+	}
+
+	fm->r0 = r0;
+	fm->z0 = z0;
+	fm->dr = (r1 - r0) / (nr - 1);
+	fm->dz = (z1 - z0) / (nz - 1);
+	fm->nr = nr;
+	fm->nz = nz;
+	fm->tr = (nr + FM_TILE - 1) / FM_TILE;
+	fm->tz = (nz + FM_TILE - 1) / FM_TILE;
+	fm->coils = coils;
+	fm->ncoil = ncoil;
+	fm->nodes = new fm_node_t[(size_t)fm->tr * fm->tz * FM_TILE * FM_TILE];
+
+	/* Samples in row major order, rows along r. */
+	size_t n = (size_t)nr * nz;
+	std::vector<double> buf(10 * n, 0.0);
+	double *r = &buf[0];
+	double *z = r + n;
+	double *Br = z + n;
+	double *Bz = Br + n;
+	double *Br_r = Bz + n;
+	double *Br_z = Br_r + n;
+	double *Bz_r = Br_z + n;
+	double *Bz_z = Bz_r + n;
+	double *Br_rz = Bz_z + n;
+	double *Bz_rz = Br_rz + n;
+	for (int j = 0; j < nz; ++j)
+	{
+		for (int i = 0; i < nr; ++i)
+		{
+			r[(size_t)j * nr + i] = r0 + i * fm->dr;
+			z[(size_t)j * nr + i] = z0 + j * fm->dz;
+		}
+	}
+
+	std::vector<mag_field_grad_2d_t> g(n);
+	for (size_t c = 0; c < ncoil; ++c)
+	{
+		solb_eval_grad_batch(&coils[c], r, z, n, &g[0]);
+		for (size_t k = 0; k < n; ++k)
+		{
+			Br[k] += g[k].Br;
+			Bz[k] += g[k].Bz;
+			Br_r[k] += g[k].dBrdr;
+			Br_z[k] += g[k].dBrdz;
+			Bz_r[k] += g[k].dBzdr;
+			Bz_z[k] += g[k].dBzdz;
+		}
+	}
+
+	for (int j = 0; j < nz; ++j)
+	{
+		fm_diff(Br_z + (size_t)j * nr, nr, 1, fm->dr, Br_rz + (size_t)j * nr);
+		fm_diff(Bz_z + (size_t)j * nr, nr, 1, fm->dr, Bz_rz + (size_t)j * nr);
+	}
+
+	for (int j = 0; j < nz; ++j)
+	{
+		for (int i = 0; i < nr; ++i)
+		{
+			size_t k = (size_t)j * nr + i;
+			fm_node_t *p = fm_node(fm, i, j);
+			p->Br = Br[k];
+			p->Bz = Bz[k];
+			p->Br_r = Br_r[k];
+			p->Br_z = Br_z[k];
+			p->Bz_r = Bz_r[k];
+			p->Bz_z = Bz_z[k];
+			p->Br_rz = Br_rz[k];
+			p->Bz_rz = Bz_rz[k];
+		}
+	}
+
+	/* Error estimate from the centers of all cells. */
+	size_t m = (size_t)(nr - 1) * (nz - 1);
+	for (int j = 0; j < nz - 1; ++j)
+	{
+		for (int i = 0; i < nr - 1; ++i)
+		{
+			r[(size_t)j * (nr - 1) + i] = r0 + (i + 0.5) * fm->dr;
+			z[(size_t)j * (nr - 1) + i] = z0 + (j + 0.5) * fm->dz;
+		}
+	}
+	fm_direct(fm, r, z, m, Br, Bz);
+	for (int mode = FM_LINEAR; mode <= FM_HERMITE; ++mode)
+	{
+		double err = 0;
+		for (size_t k = 0; k < m; ++k)
+		{
+			mag_field_2d_t B = fm_interp(fm, r[k], z[k], mode);
+			double e = fabs(B.Br - Br[k]) + fabs(B.Bz - Bz[k]);
+			err = e > err ? e : err;
+		}
+		fm->err_est[mode] = err;
+	}
+	return 1;
+}
+
+void
+fm_free(fm_map_t *fm)
+{
+	delete[] fm->nodes;
+	fm->nodes = NULL;
+}
+
+int
+fm_inside(const fm_map_t *fm, double r, double z)
+{
+	return r >= fm->r0 && r <= fm->r0 + (fm->nr - 1) * fm->dr
+		&& z >= fm->z0 && z <= fm->z0 + (fm->nz - 1) * fm->dz;
+}
+
+mag_field_2d_t
+fm_eval(const fm_map_t *fm, double r, double z, int mode)
+{
+	if (fm_inside(fm, r, z))
+		return fm_interp(fm, r, z, mode);
+
+	double Br = 0;
+	double Bz = 0;
+	for (size_t j = 0; j < fm->ncoil; ++j)
+	{
+		mag_field_2d_t res = solb_eval(&fm->coils[j], r, z);
+		Br += res.Br;
+		Bz += res.Bz;
+	}
+
+	mag_field_2d_t B{Br, Bz};
+
+	return B;
+}
+
+void
+fm_eval_batch(const fm_map_t *fm, const double *r, const double *z,
+		size_t n, int mode, double *Br, double *Bz)
+{
+	/* Probes off the map are gathered for the batch kernel of every coil. */
+	std::vector<size_t> idx;
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (fm_inside(fm, r[i], z[i]))
+		{
+			mag_field_2d_t res = fm_interp(fm, r[i], z[i], mode);
+			Br[i] = res.Br;
+			Bz[i] = res.Bz;
+		}
+		else
+			idx.push_back(i);
+	}
+	if (idx.empty())
+		return;
+
+	size_t m = idx.size();
+	std::vector<double> buf(4 * m);
+	double *ro = &buf[0];
+	double *zo = ro + m;
+	double *Bro = zo + m;
+	double *Bzo = Bro + m;
+	for (size_t i = 0; i < m; ++i)
+	{
+		ro[i] = r[idx[i]];
+		zo[i] = z[idx[i]];
+	}
+	fm_direct(fm, ro, zo, m, Bro, Bzo);
+	for (size_t i = 0; i < m; ++i)
+	{
+		Br[idx[i]] = Bro[i];
+		Bz[idx[i]] = Bzo[i];
+	}
+}
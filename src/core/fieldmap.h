@@ -0,0 +1,64 @@
+/**
+ * fieldmap.h
+ *
+ * Field map of a fixed coil set sampled once on a regular (r, z) grid and
+ * answered by linear or bicubic Hermite interpolation. Nodes are stored in
+ * square tiles so that the four corners of a cell are mostly within a single
+ * tile of a few cache lines.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __FIELDMAP_H__
+#define __FIELDMAP_H__
+
+#include "solb.h"
+
+#define FM_TILE 8 // Nodes per side of a tile
+#define FM_MIN_NODES 5 // Nodes per direction needed by the cross derivative stencil
+
+/* Interpolation modes. */
+#define FM_LINEAR 0
+#define FM_HERMITE 1
+
+/* Samples of a single grid node; derivatives are taken with respect to r
+ * and z in SI units. */
+typedef struct _fm_node_t
+{
+	double Br;
+	double Bz;
+	double Br_r;
+	double Br_z;
+	double Bz_r;
+	double Bz_z;
+	double Br_rz;
+	double Bz_rz;
+} fm_node_t;
+
+typedef struct _fm_map_t
+{
+	double r0;
+	double z0;
+	double dr;
+	double dz;
+	int nr;					/* Nodes along r */
+	int nz;					/* Nodes along z */
+	int tr;					/* Tiles along r */
+	int tz;					/* Tiles along z */
+	double err_est[2];		/* Error estimate per mode, in T: the largest |dBr| + |dBz|
+							 * at the cell centers; sampled, so not a bound */
+	fm_node_t *nodes;		/* Tiles in row major order, nodes likewise */
+	const solb_coil_t *coils;	/* Direct evaluation off the map */
+	size_t ncoil;
+} fm_map_t;
+
+/* Public interfaces. */
+int fm_build(const solb_coil_t *coils, size_t ncoil, double r0, double r1,
+		double z0, double z1, int nr, int nz, fm_map_t *fm);
+void fm_free(fm_map_t *fm);
+int fm_inside(const fm_map_t *fm, double r, double z);
+mag_field_2d_t fm_eval(const fm_map_t *fm, double r, double z, int mode);
+void fm_eval_batch(const fm_map_t *fm, const double *r, const double *z,
+		size_t n, int mode, double *Br, double *Bz);
+
+#endif
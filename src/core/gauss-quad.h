@@ -1,43 +1,147 @@
-/**
-* gauss-quad.h
-*
-* Quadrature points and weights of Gaussian quadrature with legendre poly-
-* nomials.
-*
-* Version 1.0 @ 08/14/2018
-*
-* Jaerin Lee
-* Applied Superconductivity Laboratory
-* Dept. of Electrical and Computer Engineering
-* Seoul National University
-*/
-
-#ifndef __GAUSS_QUAD_H__
-#define __GAUSS_QUAD_H__
-
-#define QUAD_ORDER 8
-
-/* 8-point */
-#define GL8X0 -.9602898564975363
-#define GL8X1 -.7966664774136267
-#define GL8X2 -.5255324099163290
-#define GL8X3 -.1834346424956498
-#define GL8X4 .1834346424956498
-#define GL8X5 .5255324099163290
-#define GL8X6 .7966664774136267
-#define GL8X7 .9602898564975363
-
-#define GL8W0 .1012285362903706
-#define GL8W1 .2223810344533744
-#define GL8W2 .3137066458778874
-#define GL8W3 .3626837833783621
-#define GL8W4 .3626837833783621
-#define GL8W5 .3137066458778874
-#define GL8W6 .2223810344533744
-#define GL8W7 .1012285362903706
-
-/* Degree of order of the Gaussian-Legendre quadrature. */
-const double x[QUAD_ORDER] = { GL8X0, GL8X1, GL8X2, GL8X3, GL8X4, GL8X5, GL8X6, GL8X7 };
-const double w[QUAD_ORDER] = { GL8W0, GL8W1, GL8W2, GL8W3, GL8W4, GL8W5, GL8W6, GL8W7 };
-
-#endif
+/**
+* gauss-quad.h
+*
+* Quadrature points and weights of Gaussian quadrature with legendre poly-
+* nomials.
+*
+* Version 1.0 @ 08/14/2018
+*
+* Jaerin Lee
+* Applied Superconductivity Laboratory
+* Dept. of Electrical and Computer Engineering
+* Seoul National University
+*/
+
+#ifndef __GAUSS_QUAD_H__
+#define __GAUSS_QUAD_H__
+
+#include <utility>
+
+#define QUAD_ORDER 8
+
+/* 8-point */
+#define GL8X0 -.9602898564975363
+#define GL8X1 -.7966664774136267
+#define GL8X2 -.5255324099163290
+#define GL8X3 -.1834346424956498
+#define GL8X4 .1834346424956498
+#define GL8X5 .5255324099163290
+#define GL8X6 .7966664774136267
+#define GL8X7 .9602898564975363
+
+#define GL8W0 .1012285362903706
+#define GL8W1 .2223810344533744
+#define GL8W2 .3137066458778874
+#define GL8W3 .3626837833783621
+#define GL8W4 .3626837833783621
+#define GL8W5 .3137066458778874
+#define GL8W6 .2223810344533744
+#define GL8W7 .1012285362903706
+
+/* Degree of order of the Gaussian-Legendre quadrature. */
+const double x[QUAD_ORDER] = { GL8X0, GL8X1, GL8X2, GL8X3, GL8X4, GL8X5, GL8X6, GL8X7 };
+const double w[QUAD_ORDER] = { GL8W0, GL8W1, GL8W2, GL8W3, GL8W4, GL8W5, GL8W6, GL8W7 };
+
+/* Rules of other orders are generated at compile time. */
+#define QUAD_ORDER_MIN 2
+#define QUAD_ORDER_MAX 32
+
+/* cos(t) for 0 <= t <= pi, usable in constant expressions. */
+constexpr double
+gq_cos(double t)
+{
+	double sgn = 1;
+	if (t > 1.5707963267948966)
+	{
+		t = 3.14159265358979323846 - t;
+		sgn = -1;
+	}
+	double term = 1;
+	double sum = 1;
+	for (int k = 1; k <= 15; ++k)
+	{
+		term *= -t * t / ((2 * k - 1) * (2 * k));
+		sum += term;
+	}
+	return sgn * sum;
+}
+
+/* Gauss-Legendre rule of order N on (-1, 1). Nodes are the roots of P_N
+ * found by Newton iteration from the asymptotic guess
+ * cos(pi * (i + 0.75) / (N + 0.5)), in ascending order as in x[]. */
+template <int N>
+struct gauss_legendre
+{
+	double x[N];
+	double w[N];
+
+	/* P_N(t) for deriv = 0, P'_N(t) otherwise, by the three-term recurrence. */
+	static constexpr double
+	legendre(double t, int deriv)
+	{
+		double p0 = 1;
+		double p1 = t;
+		for (int n = 2; n <= N; ++n)
+		{
+			double p2 = ((2 * n - 1) * t * p1 - (n - 1) * p0) / n;
+			p0 = p1;
+			p1 = p2;
+		}
+		return deriv ? N * (t * p1 - p0) / (t * t - 1) : p1;
+	}
+
+	constexpr gauss_legendre() : x(), w()
+	{
+		for (int i = 0; i < (N + 1) / 2; ++i)
+		{
+			double t = gq_cos(3.14159265358979323846 * (i + 0.75) / (N + 0.5));
+			for (int it = 0; it < 100; ++it)
+			{
+				double dt = legendre(t, 0) / legendre(t, 1);
+				t -= dt;
+				if (dt < 1e-16 && dt > -1e-16)
+					break;
+			}
+			double dp = legendre(t, 1);
+			x[N - 1 - i] = t;
+			x[i] = -t;
+			w[i] = 2 / ((1 - t * t) * dp * dp);
+			w[N - 1 - i] = w[i];
+		}
+		if (N % 2 == 1)
+			x[N / 2] = 0;
+	}
+};
+
+template <int N>
+inline constexpr gauss_legendre<N> gl_rule = gauss_legendre<N>();
+
+/* Runtime lookup of the rules of every supported order. */
+template <typename S>
+struct gl_table;
+
+template <int... I>
+struct gl_table<std::integer_sequence<int, I...>>
+{
+	static constexpr const double *x[] = { gl_rule<QUAD_ORDER_MIN + I>.x... };
+	static constexpr const double *w[] = { gl_rule<QUAD_ORDER_MIN + I>.w... };
+};
+
+typedef gl_table<std::make_integer_sequence<int,
+		QUAD_ORDER_MAX - QUAD_ORDER_MIN + 1>> gl_tables;
+
+/* Nodes and weights of the rule of a given order, which must lie in
+ * [QUAD_ORDER_MIN, QUAD_ORDER_MAX]. */
+inline const double *
+gl_nodes(int order)
+{
+	return gl_tables::x[order - QUAD_ORDER_MIN];
+}
+
+inline const double *
+gl_weights(int order)
+{
+	return gl_tables::w[order - QUAD_ORDER_MIN];
+}
+
+#endif
@@ -0,0 +1,198 @@
+/**
+ * mirror.cpp
+ *
+ * Detection of mirror symmetry. Every plane through the center of a coil or
+ * halfway between two coils of the same cross-section and current density
+ * is a candidate; the one mapping the most coils onto the set is taken.
+ * Probes are paired with their images by sorting them on (r, |z - zc|).
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "mirror.h"
+
+static inline int
+mirror_equal(double x, double y, double tol)
+{
+	return fabs(x - y) <= tol;
+}
+
+/* Whether coil m is the image of coil k about zc. */
+static inline int
+mirror_match(const solb_coil_t *k, const solb_coil_t *m, double zc, double tol)
+{
+	return mirror_equal(k->a1, m->a1, tol) && mirror_equal(k->a2, m->a2, tol)
+		&& mirror_equal(2 * zc - k->b2, m->b1, tol)
+		&& mirror_equal(2 * zc - k->b1, m->b2, tol)
+		&& k->j == m->j;
+}
+
+/* Pair the coils about zc; returns the number of coils paired. */
+static size_t
+mirror_pair(const solb_coil_t *coils, size_t ncoil, double zc, double tol,
+		long *partner)
+{
+	size_t count = 0;
+	for (size_t k = 0; k < ncoil; ++k)
+		partner[k] = -1;
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		if (partner[k] >= 0)
+			continue;
+		for (size_t m = k; m < ncoil; ++m)
+		{
+			if (partner[m] < 0 && mirror_match(&coils[k], &coils[m], zc, tol))
+			{
+				partner[k] = (long)m;
+				partner[m] = (long)k;
+				count += m == k ? 1 : 2;
+				break;
+			}
+		}
+	}
+	return count;
+}
+
+/*
+ * mirror_coils
+ * Find the plane z = zc about which the most coils are mirror images of one
+ * another. partner[k] is the index of the image of coil k, k itself if the
+ * coil is symmetric by itself, or -1 if it has none.
+ * returns the number of coils with an image, 0 if there is no symmetry
+ */
+size_t
+mirror_coils(const solb_coil_t *coils, size_t ncoil, double *zc, long *partner)
+{
+	double scale = 0;
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		scale = std::max(scale, fabs(coils[k].a2));
+		scale = std::max(scale, std::max(fabs(coils[k].b1), fabs(coils[k].b2)));
+	}
+	double tol = MIRROR_TOL * scale;
+
+	std::vector<long> trial(ncoil);
+	size_t best = 0;
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		for (size_t m = k; m < ncoil; ++m)
+		{
+			double c = (coils[k].b1 + coils[m].b2) * 0.5;
+			if (!mirror_match(&coils[k], &coils[m], c, tol))
+				continue;
+			size_t count = mirror_pair(coils, ncoil, c, tol, &trial[0]);
+			if (count > best)
+			{
+				best = count;
+				*zc = c;
+				std::copy(trial.begin(), trial.end(), partner);
+			}
+		}
+	}
+	if (best == 0)
+	{
+		for (size_t k = 0; k < ncoil; ++k)
+			partner[k] = -1;
+	}
+	return best;
+}
+
+/*
+ * mirror_probes
+ * Pair every probe with its image about zc. src[i] is the index of the
+ * probe whose field gives that of probe i by reflection, or i itself if
+ * probe i is to be evaluated; of a pair, the one below zc is evaluated.
+ * returns the number of probes to be evaluated
+ */
+size_t
+mirror_probes(const double *r, const double *z, size_t n, double zc, size_t *src)
+{
+	double scale = fabs(zc);
+	for (size_t i = 0; i < n; ++i)
+		scale = std::max(scale, std::max(fabs(r[i]), fabs(z[i])));
+	double tol = MIRROR_TOL * scale;
+
+	std::vector<size_t> idx(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		idx[i] = i;
+		src[i] = i;
+	}
+	std::sort(idx.begin(), idx.end(), [&](size_t p, size_t q) {
+		double hp = fabs(z[p] - zc);
+		double hq = fabs(z[q] - zc);
+		if (r[p] != r[q])
+			return r[p] < r[q];
+		if (hp != hq)
+			return hp < hq;
+		return p < q;
+	});
+
+	/* Images are adjacent, up to rounding; probes on the plane stay. */
+	size_t count = n;
+	for (size_t s = 0; s + 1 < n; ++s)
+	{
+		size_t p = idx[s];
+		size_t q = idx[s + 1];
+		double dp = z[p] - zc;
+		double dq = z[q] - zc;
+		if (!mirror_equal(r[p], r[q], tol) || !mirror_equal(dp, -dq, tol)
+				|| fabs(dp) <= tol || (dp > 0) == (dq > 0))
+			continue;
+		size_t lo = dp < 0 ? p : q;
+		size_t hi = dp < 0 ? q : p;
+		src[hi] = lo;
+		--count;
+		++s;
+	}
+	return count;
+}
+
+/*
+ * mirror_whole
+ * Whether every coil of a set has its image in the set about one plane,
+ * which can only be the plane halfway between the ends of the set.
+ * returns 1 and sets zc if so
+ */
+int
+mirror_whole(const solb_coil_t *coils, size_t ncoil, double *zc)
+{
+	if (ncoil == 0)
+		return 0;
+	double scale = 0;
+	double lo = coils[0].b1;
+	double hi = coils[0].b2;
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		scale = std::max(scale, fabs(coils[k].a2));
+		scale = std::max(scale, std::max(fabs(coils[k].b1), fabs(coils[k].b2)));
+		lo = std::min(lo, coils[k].b1);
+		hi = std::max(hi, coils[k].b2);
+	}
+	double c = (lo + hi) * 0.5;
+	std::vector<long> partner(ncoil);
+	if (mirror_pair(coils, ncoil, c, MIRROR_TOL * scale, &partner[0]) < ncoil)
+		return 0;
+	*zc = c;
+	return 1;
+}
+
+/*
+ * mirror_zero
+ * Set Br, or another component odd in z - zc, to +0 at the probes on the
+ * plane of a coil set mirrored as a whole, where it vanishes; the rounding of the sum leaves it a few ulps of
+ * either sign, which would print as 0 or -0 depending on the order of the
+ * sum.
+ */
+void
+mirror_zero(const double *z, size_t n, double zc, double *Br)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (z[i] == zc)
+			Br[i] = 0.0;
+	}
+}
@@ -0,0 +1,27 @@
+/**
+ * mirror.h
+ *
+ * Mirror symmetry of coil sets and probe sets about a plane z = zc. The
+ * field of a coil mirrored about zc is that of the coil at the mirrored
+ * probe with Br negated, so a probe whose mirror image is also a probe takes
+ * the field of the symmetric coils from its image.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __MIRROR_H__
+#define __MIRROR_H__
+
+#include "solb.h"
+
+#define MIRROR_TOL 1e-12 // Relative tolerance of mirrored coordinates
+
+/* Public interfaces. */
+size_t mirror_coils(const solb_coil_t *coils, size_t ncoil, double *zc,
+		long *partner);
+size_t mirror_probes(const double *r, const double *z, size_t n, double zc,
+		size_t *src);
+int mirror_whole(const solb_coil_t *coils, size_t ncoil, double *zc);
+void mirror_zero(const double *z, size_t n, double zc, double *Br);
+
+#endif
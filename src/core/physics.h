@@ -1,72 +1,112 @@
-/**
- * physics.h
- *
- * Defines data structures and rules defining physics.
- *
- * Version 1.0 @ 08/14/2018
- *
- * Jaerin Lee
- * Applied Superconductivity Laboratory
- * Dept. of Electrical and Computer Engineering
- * Seoul National University
- */
-
-#ifndef __PHYSICS_H__
-#define __PHYSICS_H__
-
-#include <stdio.h>
-
-typedef struct _vec2d_t
-{
-    double r;
-    double z;
-
-	_vec2d_t()
-	{
-		r = 0.0;
-		z = 0.0;
-	}
-
-	_vec2d_t(double r, double z)
-	{
-		this->r = r;
-		this->z = z;
-	}
-
-    _vec2d_t(const struct _vec2d_t *vec)
-    {
-        this->r = vec->r;
-        this->z = vec->z;
-    }
-} vec2d_t;
-
-typedef struct _mag_field_2d_t
-{
-	double Br;
-	double Bz;
-
-	_mag_field_2d_t()
-	{
-		Br = 0.0;
-		Bz = 0.0;
-	}
-
-	_mag_field_2d_t(double Br, double Bz)
-	{
-		this->Br = Br;
-		this->Bz = Bz;
-	}
-
-    _mag_field_2d_t(const struct _mag_field_2d_t *mag)
-    {
-        this->Br = mag->Br;
-        this->Bz = mag->Bz;
-    }
-
-	void print()
-	{
-		printf("[Field Strength]\nBr : %lf (T)\nBz : %lf (T)\n", Br, Bz);
-	}
-} mag_field_2d_t;
-
-#endif
+/**
+ * physics.h
+ *
+ * Defines data structures and rules defining physics.
+ *
+ * Version 1.0 @ 08/14/2018
+ *
+ * Jaerin Lee
+ * Applied Superconductivity Laboratory
+ * Dept. of Electrical and Computer Engineering
+ * Seoul National University
+ */
+
+#ifndef __PHYSICS_H__
+#define __PHYSICS_H__
+
+#include <stdio.h>
+
+typedef struct _vec2d_t
+{
+    double r;
+    double z;
+
+	_vec2d_t()
+	{
+		r = 0.0;
+		z = 0.0;
+	}
+
+	_vec2d_t(double r, double z)
+	{
+		this->r = r;
+		this->z = z;
+	}
+
+    _vec2d_t(const struct _vec2d_t *vec)
+    {
+        this->r = vec->r;
+        this->z = vec->z;
+    }
+} vec2d_t;
+
+typedef struct _mag_field_2d_t
+{
+	double Br;
+	double Bz;
+
+	_mag_field_2d_t()
+	{
+		Br = 0.0;
+		Bz = 0.0;
+	}
+
+	_mag_field_2d_t(double Br, double Bz)
+	{
+		this->Br = Br;
+		this->Bz = Bz;
+	}
+
+    _mag_field_2d_t(const struct _mag_field_2d_t *mag)
+    {
+        this->Br = mag->Br;
+        this->Bz = mag->Bz;
+    }
+
+	void print()
+	{
+		printf("[Field Strength]\nBr : %lf (T)\nBz : %lf (T)\n", Br, Bz);
+	}
+} mag_field_2d_t;
+
+/* Field together with its Jacobian in the (r, z) plane. */
+typedef struct _mag_field_grad_2d_t
+{
+	double Br;
+	double Bz;
+	double dBrdr;
+	double dBrdz;
+	double dBzdr;
+	double dBzdz;
+
+	_mag_field_grad_2d_t()
+	{
+		Br = 0.0;
+		Bz = 0.0;
+		dBrdr = 0.0;
+		dBrdz = 0.0;
+		dBzdr = 0.0;
+		dBzdz = 0.0;
+	}
+
+	_mag_field_grad_2d_t(double Br, double Bz, double dBrdr, double dBrdz,
+			double dBzdr, double dBzdz)
+	{
+		this->Br = Br;
+		this->Bz = Bz;
+		this->dBrdr = dBrdr;
+		this->dBrdz = dBrdz;
+		this->dBzdr = dBzdr;
+		this->dBzdz = dBzdz;
+	}
+
+	void print()
+	{
+		printf("[Field Strength]\nBr : %lf (T)\nBz : %lf (T)\n", Br, Bz);
+		printf("[Field Gradient]\ndBr/dr : %lf (T/m)\ndBr/dz : %lf (T/m)\n"
+				"dBz/dr : %lf (T/m)\ndBz/dz : %lf (T/m)\n",
+				dBrdr, dBrdz, dBzdr, dBzdz);
+	}
+} mag_field_grad_2d_t;
+
+#endif
@@ -0,0 +1,259 @@
+/**
+ * reference.cpp
+ *
+ * Reference solver in long double arithmetic. The field of a solenoid is
+ * the radial integral over a in (a1, a2) of the field of the current sheets
+ * of radius a, as in solb_internal(); here every segment of the integral is
+ * bisected until a rule of order REF_ORDER agrees with the sum over both
+ * halves, and the AGM is iterated until alpha, delta and zeta have all
+ * converged to the precision of long double, rather than to ERROR_REF.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <cfloat>
+
+#include "reference.h"
+
+#define PI_L 3.141592653589793238462643383279502884L
+#define REF_NEWTON_MAX 100 // Newton iterations of a node of the rule
+
+/* Gauss-Legendre rule of order REF_ORDER on (-1, 1) in long double. */
+typedef struct _ref_rule_t
+{
+	long double x[REF_ORDER];
+	long double w[REF_ORDER];
+} ref_rule_t;
+
+/* P_N(t) and P'_N(t) by the three-term recurrence. */
+static void
+ref_legendre(long double t, long double *p, long double *dp)
+{
+	long double p0 = 1;
+	long double p1 = t;
+	for (int k = 2; k <= REF_ORDER; ++k)
+	{
+		long double p2 = ((2 * k - 1) * t * p1 - (k - 1) * p0) / k;
+		p0 = p1;
+		p1 = p2;
+	}
+	*p = p1;
+	*dp = REF_ORDER * (t * p1 - p0) / (t * t - 1);
+}
+
+/* Nodes are found as in gauss-quad.h, by Newton iteration from
+ * cos(pi * (i + 0.75) / (N + 0.5)), but in long double. */
+static ref_rule_t
+ref_rule_build()
+{
+	ref_rule_t q;
+	for (int i = 0; i < REF_ORDER; ++i)
+	{
+		long double t = cosl(PI_L * (i + 0.75L) / (REF_ORDER + 0.5L));
+		long double p;
+		long double dp;
+		for (int it = 0; it < REF_NEWTON_MAX; ++it)
+		{
+			ref_legendre(t, &p, &dp);
+			long double dt = p / dp;
+			t -= dt;
+			if (fabsl(dt) <= LDBL_EPSILON)
+				break;
+		}
+		ref_legendre(t, &p, &dp);
+		q.x[REF_ORDER - 1 - i] = t;
+		q.w[REF_ORDER - 1 - i] = 2 / ((1 - t * t) * dp * dp);
+	}
+	return q;
+}
+
+static const ref_rule_t &
+ref_rule()
+{
+	static const ref_rule_t q = ref_rule_build();
+	return q;
+}
+
+/* Integrand of the radial integral of both end faces at node radius a, per
+ * unit weight; see lane_kernel_agm(). */
+static void
+ref_integrand(long double a, long double r, const long double *dz,
+		long double rinv, long double *fr, long double *fz)
+{
+	*fr = 0;
+	*fz = 0;
+	for (int f = 0; f < 2; ++f)
+	{
+		long double aprsq = (a + r) * (a + r);
+		long double amrsq = (a - r) * (a - r);
+		long double dzsq = dz[f] * dz[f];
+		long double r1 = sqrtl(aprsq + dzsq);
+		long double r2 = sqrtl(amrsq + dzsq);
+
+		/* Only a node on the edge of the sheet itself is singular. */
+		if (r2 == 0)
+			continue;
+
+		long double alpha = 1;
+		long double beta = r2 / r1;
+		long double delta = amrsq * r1 / (aprsq * r2);
+		long double epsilon = 4 * a * r / amrsq;
+		long double zeta = 0;
+		long double SG = 0;
+		for (int j = 0; j < REF_AGM_MAX; ++j)
+		{
+			long double d = alpha - beta;
+			SG += ldexpl(d * d, j);
+			if (fabsl(d) <= 4 * LDBL_EPSILON * alpha
+					&& fabsl(1 - delta) <= 4 * LDBL_EPSILON
+					&& fabsl(epsilon - zeta) <= 4 * LDBL_EPSILON * fabsl(zeta))
+				break;
+
+			long double temp = sqrtl(alpha * beta);
+			alpha = (alpha + beta) * 0.5L;
+			beta = temp;
+			temp = (epsilon + zeta) * 0.5L;
+			epsilon = (delta * epsilon + zeta) / (1 + delta);
+			zeta = temp;
+			delta = (2 + delta + 1 / delta) * beta / (4 * alpha);
+		}
+
+		/* The b2 face takes the weights of b1 negated. */
+		long double sgn = f ? -1 : 1;
+		*fr -= sgn * rinv * SG * 0.5L * r1 / alpha;
+		*fz += sgn * dz[f] * (2 * a + (a - r) * zeta) / ((a + r) * r1 * alpha);
+	}
+}
+
+/* Rule of order REF_ORDER over a single panel. */
+static void
+ref_panel(long double lo, long double hi, long double r, const long double *dz,
+		long double rinv, long double *I)
+{
+	const ref_rule_t &q = ref_rule();
+	long double mid = (lo + hi) * 0.5L;
+	long double hw = (hi - lo) * 0.5L;
+	I[0] = 0;
+	I[1] = 0;
+	for (int i = 0; i < REF_ORDER; ++i)
+	{
+		long double fr;
+		long double fz;
+		ref_integrand(mid + hw * q.x[i], r, dz, rinv, &fr, &fz);
+		I[0] += q.w[i] * fr;
+		I[1] += q.w[i] * fz;
+	}
+	I[0] *= hw;
+	I[1] *= hw;
+}
+
+/* Bisect a panel, of integral whole, until both halves sum to it within
+ * tol; the ends of a segment at a = r are reached geometrically. */
+static void
+ref_adapt(long double lo, long double hi, long double r, const long double *dz,
+		long double rinv, const long double *whole, long double tol, int depth,
+		long double *acc)
+{
+	long double mid = (lo + hi) * 0.5L;
+	long double L[2];
+	long double R[2];
+	ref_panel(lo, mid, r, dz, rinv, L);
+	ref_panel(mid, hi, r, dz, rinv, R);
+	long double diff = fabsl(L[0] + R[0] - whole[0]) + fabsl(L[1] + R[1] - whole[1]);
+	if (diff <= tol || depth >= REF_MAX_DEPTH)
+	{
+		acc[0] += L[0] + R[0];
+		acc[1] += L[1] + R[1];
+		return;
+	}
+	ref_adapt(lo, mid, r, dz, rinv, L, tol, depth + 1, acc);
+	ref_adapt(mid, hi, r, dz, rinv, R, tol, depth + 1, acc);
+}
+
+/* Field of a single coil, added to Br and Bz. */
+static void
+ref_coil(const solb_coil_t *coil, long double r, long double z,
+		long double *Br, long double *Bz)
+{
+	long double dz[2] = { z - coil->b1, z - coil->b2 };
+	long double rinv = r > 0 ? 0.5L / r : 0;
+
+	/* Probes inside the winding split the integral at r. */
+	long double edge[3];
+	int ne = 0;
+	edge[ne++] = coil->a1;
+	if (r > coil->a1 && r < coil->a2)
+		edge[ne++] = r;
+	edge[ne++] = coil->a2;
+
+	long double whole[2][2];
+	long double scale = 0;
+	for (int s = 0; s + 1 < ne; ++s)
+	{
+		ref_panel(edge[s], edge[s + 1], r, dz, rinv, whole[s]);
+		scale += fabsl(whole[s][0]) + fabsl(whole[s][1]);
+	}
+
+	long double acc[2] = { 0, 0 };
+	for (int s = 0; s + 1 < ne; ++s)
+		ref_adapt(edge[s], edge[s + 1], r, dz, rinv, whole[s], REF_TOL * scale, 0,
+				acc);
+
+	/* Twice solb_coil_t.c; its weights sum to 2 over (-1, 1). */
+	long double c = 1e-7L * coil->j * PI_L;
+	*Br += c * acc[0];
+	*Bz += c * acc[1];
+}
+
+/*
+ * ref_eval
+ * Field of a coil set at a single probe, summed in long double.
+ */
+void
+ref_eval(const solb_coil_t *coils, size_t ncoil, double r, double z,
+		long double *Br, long double *Bz)
+{
+	*Br = 0;
+	*Bz = 0;
+	for (size_t j = 0; j < ncoil; ++j)
+		ref_coil(&coils[j], r, z, Br, Bz);
+}
+
+void
+ref_eval_batch(const solb_coil_t *coils, size_t ncoil, const double *r,
+		const double *z, size_t n, double *Br, double *Bz)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		long double br;
+		long double bz;
+		ref_eval(coils, ncoil, r[i], z[i], &br, &bz);
+		Br[i] = br;
+		Bz[i] = bz;
+	}
+}
+
+/*
+ * ref_axis
+ * On-axis field of a coil set in closed form, as in zonal.cpp,
+ * Bz(0, z) = mu0 * j / 2 * (F(z - b1) - F(z - b2)),
+ * F(u) = u * log((a2 + sqrt(a2 ** 2 + u ** 2)) / (a1 + sqrt(a1 ** 2 + u ** 2))),
+ * which checks the quadrature of ref_eval() independently.
+ */
+long double
+ref_axis(const solb_coil_t *coils, size_t ncoil, double z)
+{
+	long double Bz = 0;
+	for (size_t j = 0; j < ncoil; ++j)
+	{
+		long double a1 = coils[j].a1;
+		long double a2 = coils[j].a2;
+		long double u[2] = { z - coils[j].b1, z - coils[j].b2 };
+		long double F[2];
+		for (int f = 0; f < 2; ++f)
+			F[f] = u[f] * logl((a2 + sqrtl(a2 * a2 + u[f] * u[f]))
+					/ (a1 + sqrtl(a1 * a1 + u[f] * u[f])));
+		Bz += 2e-7L * PI_L * coils[j].j * (F[0] - F[1]);
+	}
+	return Bz;
+}
@@ -0,0 +1,31 @@
+/**
+ * reference.h
+ *
+ * Reference solver, against which the production kernels are checked. The
+ * radial integral of every end face is taken in long double arithmetic by
+ * adaptive Gauss-Legendre quadrature of high order, and the elliptic
+ * integrals by Garrett's AGM iteration run to the precision of long double.
+ * Orders of magnitude slower than solb_eval(); meant for accuracy maps, not
+ * for production runs.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __REFERENCE_H__
+#define __REFERENCE_H__
+
+#include "solb.h"
+
+#define REF_ORDER 20 // Order of the Gauss-Legendre rule of a panel
+#define REF_TOL 1e-17L // Tolerance of a panel, relative to the radial integral
+#define REF_MAX_DEPTH 64 // Bisections of a single panel
+#define REF_AGM_MAX 128 // Iterations of the AGM; slow only as a reaches r
+
+/* Public interfaces. */
+void ref_eval(const solb_coil_t *coils, size_t ncoil, double r, double z,
+		long double *Br, long double *Bz);
+void ref_eval_batch(const solb_coil_t *coils, size_t ncoil, const double *r,
+		const double *z, size_t n, double *Br, double *Bz);
+long double ref_axis(const solb_coil_t *coils, size_t ncoil, double z);
+
+#endif
@@ -1,336 +1,1889 @@
-/**
- * solb.cpp
- *
- * Alternative version of SolB written in C with LAPACKE. Calculate magnetic
- * field by an arbitrary solenoid
- *
- * Version 1.0 @ 08/14/2018
- *
- * Jaerin Lee
- * Applied Superconductivity Laboratory
- * Dept. of Electrical and Computer Engineering
- * Seoul National University
- */
-
-#include "solb.h"
-
-#define M_PI 3.14159265358979323846
-#define NEAR_CENTER_THRESHOLD 1e-6
-#define ERROR_REF 1e-10
-
-/* Function premitives. */
-mag_field_2d_t solb_internal(const top_solenoid_t *sol, double r, double z);
-
-mag_field_2d_t
-solb_single(const top_solenoid_t *sol, double r, double z)
-{
-    static const char *label = "solb_single";
-
-	/* Handle bad inputs. */
-	if (sol == NULL)
-	{
-		fprintf(stderr, "%s: No solenoid has been specified.", label);
-
-        mag_field_2d_t B{0, 0};
-
-		return B;
-	}
-
-	/* Caching dimensions of the solenoid. */
-	double a1 = sol->a1;
-	double a2 = sol->a2;
-	double j = sol->j;
-
-	/* Handling bad solenoid dimensions. */
-	if (a2 < a1 || sol->b2 < sol->b1)
-	{
-		fprintf(stderr, "%s: Wrong solenoid dimension.", label);
-
-        mag_field_2d_t B{0, 0};
-
-		return B;
-	}
-
-	if (r > a1 && r < a2)
-	{
-		top_solenoid_t inner(*sol);
-		top_solenoid_t outer(*sol);
-		inner.a2 = r;
-		outer.a1 = r;
-
-		mag_field_2d_t resInner = solb_internal(&inner, r, z);
-		double dtmp0 = 0.5e-7 * j * M_PI;
-		double dtmp1 = dtmp0 * (r - a1);
-		/* Note 1 */
-		double dtmp2 = (r / a1 < NEAR_CENTER_THRESHOLD) ? 0 : 0.5 / r;
-		double Br = resInner.Br * dtmp1 * dtmp2;
-		double Bz = resInner.Bz * dtmp1;
-
-		mag_field_2d_t resOuter = solb_internal(&outer, r, z);
-		dtmp1 = dtmp0 * (a2 - r);
-		Br += resOuter.Br * dtmp1 * dtmp2;
-		Bz += resOuter.Bz * dtmp1;
-
-        mag_field_2d_t B{Br, Bz};
-
-		return B;
-	}
-	else
-	{
-		mag_field_2d_t res = solb_internal(sol, r, z);
-		double Br = res.Br;
-		double Bz = res.Bz;
-		double dtmp = 0.5e-7 * j * (a2 - a1) * M_PI;
-
-		/* Note 1: Exception for near-center field. Field calculation in this way
-		 * yields 0 / 0 division causing severe computational error term. */
-		if (r / a1 < NEAR_CENTER_THRESHOLD)
-			Br = 0.0;
-		else
-			Br *= 0.5 * dtmp / r;
-		Bz *= dtmp;
-
-        mag_field_2d_t B{Br, Bz};
-
-		return B;
-	}
-}
-
-mag_field_2d_t
-solb_internal(const top_solenoid_t *sol, double r, double z)
-{
-	/* Caching dimensions of the solenoid. */
-	double a1 = sol->a1;
-	double a2 = sol->a2;
-
-	/* Calculate quadrature points. */
-	double a[QUAD_ORDER];
-	double dtmp = (a1 + a2) * 0.5;
-	cblas_dcopy(QUAD_ORDER, x, 1, a, 1);
-	cblas_daxpby(QUAD_ORDER, 1, &dtmp, 0, (a2 - a1) * 0.5, a, 1); // End of using dtmp
-
-	/* Intermediate values. */
-	double datmp0[QUAD_ORDER];
-	double datmp1[QUAD_ORDER];
-	double datmp2[QUAD_ORDER];
-	double aprsq[QUAD_ORDER];
-	double amrsq[QUAD_ORDER];
-	cblas_dcopy(QUAD_ORDER, a, 1, datmp0, 1);
-	cblas_daxpy(QUAD_ORDER, 1, &r, 0, datmp0, 1);
-	vdSqr(QUAD_ORDER, datmp0, aprsq);
-	cblas_dcopy(QUAD_ORDER, a, 1, datmp0, 1);
-	cblas_daxpy(QUAD_ORDER, -1, &r, 0, datmp0, 1);
-	vdSqr(QUAD_ORDER, datmp0, amrsq);
-
-	/* For a single solenoid, total 2 * Gaussian quadrature points amount of
-	 * calculations are needed. */
-
-	/* First iteration. */
-	double h = sol->b1;
-
-	/* Preparation of common parameters.
-	 * r1sq = (a + r) ** 2 + (z - h) ** 2	| make this
-	 * r2sq = (a - r) ** 2 + (z - h) ** 2	| make this
-	 * ksq  = 4 * a * r / r1sq				|
-	 * kpsq = r2sq / r1sq					| make this
-	 * csq  = 4 * a * r / (a + r) ** 2		|
-	 * cpsq = (a - r) ** 2 / (a + r) ** 2	| make this
-	 */
-	double kpsq[QUAD_ORDER];
-	double kp[QUAD_ORDER];
-	dtmp = z - h;
-	dtmp *= dtmp;
-	vdLinearFrac(QUAD_ORDER, amrsq, aprsq, 1, dtmp, 1, dtmp, kpsq);
-	vdSqrt(QUAD_ORDER, kpsq, kp);
-	double cpsq[QUAD_ORDER];
-	vdDiv(QUAD_ORDER, amrsq, aprsq, cpsq);
-	double r1sq[QUAD_ORDER];
-	cblas_dcopy(QUAD_ORDER, aprsq, 1, r1sq, 1);
-	double r1[QUAD_ORDER];
-	cblas_daxpy(QUAD_ORDER, 1, &dtmp, 0, r1sq, 1);
-	vdSqrt(QUAD_ORDER, r1sq, r1);
-
-	/* Calculation of initial values of iterative methods.
-	 * alpha0	= 1							|
-	 * beta0	= kp						|
-	 * S0		= ksq						| not needed
-	 * SG		= 0							|
-	 * delta0	= cpsq / kp					|
-	 * epsilon0 = csq / cpsq				|
-	 * zeta0    = 0							|
-	 */
-	double *beta0a = kp;
-	double delta0a[QUAD_ORDER];
-	double epsilon0a[QUAD_ORDER];
-	vdLinearFrac(QUAD_ORDER, cpsq, kp, 1, 0, 1, 0, delta0a);
-	vdLinearFrac(QUAD_ORDER, cpsq, cpsq, -1, 1, 1, 0, epsilon0a);
-
-	double alphaInf[QUAD_ORDER];
-	double zetaInf[QUAD_ORDER];
-	double SGInf[QUAD_ORDER];
-	for (int i = 0; i < QUAD_ORDER; ++i)
-	{
-		/* Initialization of iterative method. */
-		double alpha = 1;
-		double beta = beta0a[i];
-		double delta = delta0a[i];
-		double epsilon = epsilon0a[i];
-		double zeta = 0;
-		double SG = 0;
-
-		/* Main iterative loop.
-		 * alphaNext = AM(alpha, beta)
-		 * betaNext = GM(alpha, beta)
-		 * deltaNext = (betaNext / (4 * alphaNext)) * (2 + delta + 1 / delta)
-		 * epsilonNext = delta * (epsilon + zeta) / (1 + delta)
-		 * zetaNext = AM(epsilon, zeta)
-		 * Garrett's Sum = SIGMA_i_0_to_inf(2 ** (i - 1) * (alpha - beta) ** 2)
-		 */
-		int j = 0;
-		double error = 1;
-		while (1)
-		{
-			/* Update Garrett's sum. */
-			double temp = (alpha - beta);
-			temp *= temp;
-			temp *= double(1 << j);
-			SG += temp;
-			if (error < ERROR_REF && abs(1 - delta) < ERROR_REF) break;
-
-			/* Evaluate the error. */
-			error = temp;
-
-			/* Update iterative variables. */
-			temp = sqrt(alpha * beta);
-			alpha = (alpha + beta) * 0.5;
-			beta = temp;
-			temp = (epsilon + zeta) / 2;
-			epsilon = (delta * epsilon + zeta) / (1 + delta);
-			zeta = temp;
-			delta = (2 + delta + 1 / delta) * beta / (4 * alpha);
-
-			++j;
-		}
-
-		alphaInf[i] = alpha;
-		zetaInf[i] = zeta;
-		SGInf[i] = SG * 0.5;
-	}
-
-	/* Calculation of B. */
-	vdMul(QUAD_ORDER, w, r1, datmp0);
-	vdDiv(QUAD_ORDER, SGInf, alphaInf, datmp1);
-	double BrDiff = -cblas_ddot(QUAD_ORDER, datmp0, 1, datmp1, 1);
-	
-	vdAdd(QUAD_ORDER, a, a, datmp0);
-	vdLinearFrac(QUAD_ORDER, a, datmp0, 1, -r, 0, 1, datmp1);
-	vdMul(QUAD_ORDER, datmp1, zetaInf, datmp2);
-	vdAdd(QUAD_ORDER, datmp0, datmp2, datmp1);
-	vdLinearFrac(QUAD_ORDER, a, datmp1, 1, r, 0, 1, datmp0);
-	vdMul(QUAD_ORDER, datmp0, r1, datmp2);
-	vdMul(QUAD_ORDER, datmp2, alphaInf, datmp0);
-	vdDiv(QUAD_ORDER, datmp1, datmp0, datmp2);
-	double BzDiff = cblas_ddot(QUAD_ORDER, w, 1, datmp2, 1) * (z - h);
-
-	/* Second iteration. */
-	h = sol->b2; // DIFF
-
-	/* Preparation of common parameters.
-	 * r1sq = (a + r) ** 2 + (z - h) ** 2	| make this
-	 * r2sq = (a - r) ** 2 + (z - h) ** 2	| make this
-	 * ksq  = 4 * a * r / r1sq				|
-	 * kpsq = r2sq / r1sq					| make this
-	 * csq  = 4 * a * r / (a + r) ** 2		|
-	 * cpsq = (a - r) ** 2 / (a + r) ** 2	| make this
-	 */
-	dtmp = z - h;
-	dtmp *= dtmp;
-	vdLinearFrac(QUAD_ORDER, amrsq, aprsq, 1, dtmp, 1, dtmp, kpsq);
-	vdSqrt(QUAD_ORDER, kpsq, kp);
-	vdDiv(QUAD_ORDER, amrsq, aprsq, cpsq);
-	cblas_dcopy(QUAD_ORDER, aprsq, 1, r1sq, 1);
-	cblas_daxpy(QUAD_ORDER, 1, &dtmp, 0, r1sq, 1);
-	vdSqrt(QUAD_ORDER, r1sq, r1);
-
-	/* Calculation of initial values of iterative methods.
-	 * alpha0	= 1							|
-	 * beta0	= kp						|
-	 * S0		= ksq						| not needed
-	 * SG		= 0							|
-	 * delta0	= cpsq / kp					|
-	 * epsilon0 = csq / cpsq				|
-	 * zeta0    = 0							|
-	 */
-	beta0a = kp;
-	vdLinearFrac(QUAD_ORDER, cpsq, kp, 1, 0, 1, 0, delta0a);
-	vdLinearFrac(QUAD_ORDER, cpsq, cpsq, -1, 1, 1, 0, epsilon0a);
-
-	for (int i = 0; i < QUAD_ORDER; ++i)
-	{
-		/* Initialization of iterative method. */
-		double alpha = 1;
-		double beta = beta0a[i];
-		double delta = delta0a[i];
-		double epsilon = epsilon0a[i];
-		double zeta = 0;
-		double SG = 0;
-
-		/* Main iterative loop.
-		 * alphaNext = AM(alpha, beta)
-		 * betaNext = GM(alpha, beta)
-		 * deltaNext = (betaNext / (4 * alphaNext)) * (2 + delta + 1 / delta)
-		 * epsilonNext = delta * (epsilon + zeta) / (1 + delta)
-		 * zetaNext = AM(epsilon, zeta)
-		 * Garrett's Sum = SIGMA_i_0_to_inf(2 ** (i - 1) * (alpha - beta) ** 2)
-		 */
-		int j = 0;
-		double error = 1;
-		while (1)
-		{
-			/* Update Garrett's sum. */
-			double temp = (alpha - beta);
-			temp *= temp;
-			temp *= double(1 << j);
-			SG += temp;
-			if (error < ERROR_REF && abs(1 - delta) < ERROR_REF) break;
-
-			/* Evaluate the error. */
-			error = temp;
-
-			/* Update iterative variables. */
-			temp = sqrt(alpha * beta);
-			alpha = (alpha + beta) * 0.5;
-			beta = temp;
-			temp = (epsilon + zeta) / 2;
-			epsilon = (delta * epsilon + zeta) / (1 + delta);
-			zeta = temp;
-			delta = (2 + delta + 1 / delta) * beta / (4 * alpha);
-
-			++j;
-		}
-
-		alphaInf[i] = alpha;
-		zetaInf[i] = zeta;
-		SGInf[i] = SG * 0.5;
-	}
-
-	/* Calculation of B. */
-	vdMul(QUAD_ORDER, w, r1, datmp0);
-	vdDiv(QUAD_ORDER, SGInf, alphaInf, datmp1);
-	BrDiff += cblas_ddot(QUAD_ORDER, datmp0, 1, datmp1, 1); // DIFF
-	
-	vdAdd(QUAD_ORDER, a, a, datmp0);
-	vdLinearFrac(QUAD_ORDER, a, datmp0, 1, -r, 0, 1, datmp1);
-	vdMul(QUAD_ORDER, datmp1, zetaInf, datmp2);
-	vdAdd(QUAD_ORDER, datmp0, datmp2, datmp1);
-	vdLinearFrac(QUAD_ORDER, a, datmp1, 1, r, 0, 1, datmp0);
-	vdMul(QUAD_ORDER, datmp0, r1, datmp2);
-	vdMul(QUAD_ORDER, datmp2, alphaInf, datmp0);
-	vdDiv(QUAD_ORDER, datmp1, datmp0, datmp2);
-	BzDiff -= cblas_ddot(QUAD_ORDER, w, 1, datmp2, 1) * (z - h); // DIFF
-
-	mag_field_2d_t ans;
-    ans.Br = BrDiff;
-    ans.Bz = BzDiff;
-    return ans;
-}
+/**
+ * solb.cpp
+ *
+ * Alternative version of SolB written in C with LAPACKE. Calculate magnetic
+ * field by an arbitrary solenoid
+ *
+ * Version 1.0 @ 08/14/2018
+ *
+ * Jaerin Lee
+ * Applied Superconductivity Laboratory
+ * Dept. of Electrical and Computer Engineering
+ * Seoul National University
+ */
+
+#include <algorithm>
+#include <complex>
+#include <cstring>
+#include <vector>
+
+#include "solb.h"
+#include "stats.h"
+
+#define M_PI 3.14159265358979323846
+#define NEAR_CENTER_THRESHOLD 1e-6
+#define ERROR_REF 1e-10
+#define LANE_GROUP (2 * QUAD_ORDER) // Lanes of a single probe; both end faces
+#define LANE_PAD 8 // Idle lanes are padded up to a multiple of this
+#define BATCH_LANES (2 * LANE_GROUP) // Lanes per block of the batch kernel
+#define ADAPT_MAX_PANELS 32 // Panels per end face and radial segment
+#define ADAPT_MAX_DEPTH 40 // Bisections of a single panel
+#define ADAPT_GROUP 4 // Probes sharing a lane block in adaptive mode
+#define CARLSON_STEPS 8 // Duplication steps of the closed-form kernel
+#define AGM_F32_MAX 64 // Iterations of the AGM in float; a bound, the slowest lanes take 7
+#define GRADE_REACH 0.15 // Distance from an end face, per segment length, within which a segment is graded
+#define MUTUAL_GRADING 0.15 // Ratio of the axial panels graded towards d = 0
+#define MUTUAL_MAX_LEVEL 24 // Graded panels per side of d = 0
+
+/* Accuracy tiers. Relaxed tiers stop the kernels earlier, and take for
+ * every radial segment of a probe the lowest order of TIER_LADDER that the
+ * error estimate of the radial integral allows, up to the compiled order;
+ * see lane_column_push(). The full tier keeps the compiled order everywhere,
+ * on the nodes of solb_single(), so that no relaxed tier is more accurate.
+ * The estimate is relative to the field of a single coil, so the tiers keep
+ * a margin of 100 for coil sets whose fields cancel. The single tier runs
+ * the AGM iteration in float, see lane_kernel_agm_f32(); float cannot hold
+ * the margin, so its order is chosen for 1e-7 and the rounding of the
+ * kernel bounds it. The fine tier refines the full one near the windings:
+ * nodes graded towards r by the end faces, a split at r beside the winding,
+ * and the order the estimate calls for above the compiled one, up to 32. */
+typedef struct _solb_tier_t
+{
+	const char *name;
+	double tol;				/* Error estimate of the order; 0 to keep the compiled one */
+	double agm;				/* AGM convergence, as ERROR_REF */
+	int steps;				/* Duplication steps of the Carlson kernel */
+	int f32;				/* AGM iteration in single precision */
+	int fine;				/* Graded nodes, and orders at or above the compiled one */
+} solb_tier_t;
+
+static const solb_tier_t solb_tiers[SOLB_NTIER] = {
+	{ "full", 0, ERROR_REF, CARLSON_STEPS, 0, 0 },
+	{ "ppb", 1e-11, ERROR_REF, 5, 0, 0 },
+	{ "ppm", 1e-8, 1e-7, 4, 0, 0 },
+	{ "single", 1e-7, 1e-6, 4, 1, 0 },
+	{ "fine", 1e-11, ERROR_REF, CARLSON_STEPS, 0, 1 }
+};
+
+#define TIER_LADDER 9
+static const int tier_orders[TIER_LADDER] = { 2, 3, 4, 6, 8, 12, 16, 24, 32 };
+
+/* Function premitives. */
+mag_field_2d_t solb_internal(const top_solenoid_t *sol, double r, double z);
+
+mag_field_2d_t
+solb_single(const top_solenoid_t *sol, double r, double z)
+{
+    static const char *label = "solb_single";
+
+	/* Handle bad inputs. */
+	if (sol == NULL)
+	{
+		fprintf(stderr, "%s: No solenoid has been specified.", label);
+
+        mag_field_2d_t B{0, 0};
+
+		return B;
+	}
+
+	/* Caching dimensions of the solenoid. */
+	double a1 = sol->a1;
+	double a2 = sol->a2;
+	double j = sol->j;
+
+	/* Handling bad solenoid dimensions. */
+	if (a2 < a1 || sol->b2 < sol->b1)
+	{
+		fprintf(stderr, "%s: Wrong solenoid dimension.", label);
+
+        mag_field_2d_t B{0, 0};
+
+		return B;
+	}
+
+	if (r > a1 && r < a2)
+	{
+		/* Compiled coils take both segments in a single pass of the batch
+		 * kernel instead; see lane_column_init(). */
+		unsigned long long t0 = stats_now();
+		top_solenoid_t inner(*sol);
+		top_solenoid_t outer(*sol);
+		inner.a2 = r;
+		outer.a1 = r;
+
+		mag_field_2d_t resInner = solb_internal(&inner, r, z);
+		double dtmp0 = 0.5e-7 * j * M_PI;
+		double dtmp1 = dtmp0 * (r - a1);
+		/* Note 1 */
+		double dtmp2 = (r / a1 < NEAR_CENTER_THRESHOLD) ? 0 : 0.5 / r;
+		double Br = resInner.Br * dtmp1 * dtmp2;
+		double Bz = resInner.Bz * dtmp1;
+
+		mag_field_2d_t resOuter = solb_internal(&outer, r, z);
+		dtmp1 = dtmp0 * (a2 - r);
+		Br += resOuter.Br * dtmp1 * dtmp2;
+		Bz += resOuter.Bz * dtmp1;
+
+		stats_count(STATS_SINGLE, 1);
+		stats_count(STATS_SINGLE_INSIDE, 1);
+		stats_time(STATS_T_INSIDE, t0);
+
+        mag_field_2d_t B{Br, Bz};
+
+		return B;
+	}
+	else
+	{
+		stats_count(STATS_SINGLE, 1);
+		mag_field_2d_t res = solb_internal(sol, r, z);
+		double Br = res.Br;
+		double Bz = res.Bz;
+		double dtmp = 0.5e-7 * j * (a2 - a1) * M_PI;
+
+		/* Note 1: Exception for near-center field. Field calculation in this way
+		 * yields 0 / 0 division causing severe computational error term. */
+		if (r / a1 < NEAR_CENTER_THRESHOLD)
+			Br = 0.0;
+		else
+			Br *= 0.5 * dtmp / r;
+		Bz *= dtmp;
+
+        mag_field_2d_t B{Br, Bz};
+
+		return B;
+	}
+}
+
+mag_field_2d_t
+solb_internal(const top_solenoid_t *sol, double r, double z)
+{
+	/* Caching dimensions of the solenoid. */
+	double a1 = sol->a1;
+	double a2 = sol->a2;
+
+	/* Calculate quadrature points. */
+	double a[QUAD_ORDER];
+	double dtmp = (a1 + a2) * 0.5;
+	vm_copy(QUAD_ORDER, x, 1, a, 1);
+	vm_axpby(QUAD_ORDER, 1, &dtmp, 0, (a2 - a1) * 0.5, a, 1); // End of using dtmp
+
+	/* Intermediate values. */
+	double datmp0[QUAD_ORDER];
+	double datmp1[QUAD_ORDER];
+	double datmp2[QUAD_ORDER];
+	double aprsq[QUAD_ORDER];
+	double amrsq[QUAD_ORDER];
+	vm_copy(QUAD_ORDER, a, 1, datmp0, 1);
+	vm_axpy(QUAD_ORDER, 1, &r, 0, datmp0, 1);
+	vm_sqr(QUAD_ORDER, datmp0, aprsq);
+	vm_copy(QUAD_ORDER, a, 1, datmp0, 1);
+	vm_axpy(QUAD_ORDER, -1, &r, 0, datmp0, 1);
+	vm_sqr(QUAD_ORDER, datmp0, amrsq);
+
+	/* For a single solenoid, total 2 * Gaussian quadrature points amount of
+	 * calculations are needed. */
+
+	/* AGM iterations of every node are counted, and both passes timed. */
+	stats_t *st = stats_enabled ? stats_local() : NULL;
+	unsigned long long t0 = stats_now();
+
+	/* First iteration. */
+	double h = sol->b1;
+
+	/* Preparation of common parameters.
+	 * r1sq = (a + r) ** 2 + (z - h) ** 2	| make this
+	 * r2sq = (a - r) ** 2 + (z - h) ** 2	| make this
+	 * ksq  = 4 * a * r / r1sq				|
+	 * kpsq = r2sq / r1sq					| make this
+	 * csq  = 4 * a * r / (a + r) ** 2		|
+	 * cpsq = (a - r) ** 2 / (a + r) ** 2	| make this
+	 */
+	double kpsq[QUAD_ORDER];
+	double kp[QUAD_ORDER];
+	dtmp = z - h;
+	dtmp *= dtmp;
+	vm_linear_frac(QUAD_ORDER, amrsq, aprsq, 1, dtmp, 1, dtmp, kpsq);
+	vm_sqrt(QUAD_ORDER, kpsq, kp);
+	double cpsq[QUAD_ORDER];
+	vm_div(QUAD_ORDER, amrsq, aprsq, cpsq);
+	double r1sq[QUAD_ORDER];
+	vm_copy(QUAD_ORDER, aprsq, 1, r1sq, 1);
+	double r1[QUAD_ORDER];
+	vm_axpy(QUAD_ORDER, 1, &dtmp, 0, r1sq, 1);
+	vm_sqrt(QUAD_ORDER, r1sq, r1);
+
+	/* Calculation of initial values of iterative methods.
+	 * alpha0	= 1							|
+	 * beta0	= kp						|
+	 * S0		= ksq						| not needed
+	 * SG		= 0							|
+	 * delta0	= cpsq / kp					|
+	 * epsilon0 = csq / cpsq				|
+	 * zeta0    = 0							|
+	 */
+	double *beta0a = kp;
+	double delta0a[QUAD_ORDER];
+	double epsilon0a[QUAD_ORDER];
+	vm_linear_frac(QUAD_ORDER, cpsq, kp, 1, 0, 1, 0, delta0a);
+	vm_linear_frac(QUAD_ORDER, cpsq, cpsq, -1, 1, 1, 0, epsilon0a);
+
+	double alphaInf[QUAD_ORDER];
+	double zetaInf[QUAD_ORDER];
+	double SGInf[QUAD_ORDER];
+	for (int i = 0; i < QUAD_ORDER; ++i)
+	{
+		/* Initialization of iterative method. */
+		double alpha = 1;
+		double beta = beta0a[i];
+		double delta = delta0a[i];
+		double epsilon = epsilon0a[i];
+		double zeta = 0;
+		double SG = 0;
+
+		/* Main iterative loop.
+		 * alphaNext = AM(alpha, beta)
+		 * betaNext = GM(alpha, beta)
+		 * deltaNext = (betaNext / (4 * alphaNext)) * (2 + delta + 1 / delta)
+		 * epsilonNext = delta * (epsilon + zeta) / (1 + delta)
+		 * zetaNext = AM(epsilon, zeta)
+		 * Garrett's Sum = SIGMA_i_0_to_inf(2 ** (i - 1) * (alpha - beta) ** 2)
+		 */
+		int j = 0;
+		double error = 1;
+		while (1)
+		{
+			/* Update Garrett's sum. */
+			double temp = (alpha - beta);
+			temp *= temp;
+			temp *= double(1 << j);
+			SG += temp;
+			if (error < ERROR_REF && abs(1 - delta) < ERROR_REF) break;
+
+			/* Evaluate the error. */
+			error = temp;
+
+			/* Update iterative variables. */
+			temp = sqrt(alpha * beta);
+			alpha = (alpha + beta) * 0.5;
+			beta = temp;
+			temp = (epsilon + zeta) / 2;
+			epsilon = (delta * epsilon + zeta) / (1 + delta);
+			zeta = temp;
+			delta = (2 + delta + 1 / delta) * beta / (4 * alpha);
+
+			++j;
+		}
+
+		alphaInf[i] = alpha;
+		zetaInf[i] = zeta;
+		SGInf[i] = SG * 0.5;
+		if (st != NULL)
+			++st->agm[stats_agm_bin(j)];
+	}
+
+	/* Calculation of B. */
+	vm_mul(QUAD_ORDER, w, r1, datmp0);
+	vm_div(QUAD_ORDER, SGInf, alphaInf, datmp1);
+	double BrDiff = -vm_dot(QUAD_ORDER, datmp0, 1, datmp1, 1);
+	
+	vm_add(QUAD_ORDER, a, a, datmp0);
+	vm_linear_frac(QUAD_ORDER, a, datmp0, 1, -r, 0, 1, datmp1);
+	vm_mul(QUAD_ORDER, datmp1, zetaInf, datmp2);
+	vm_add(QUAD_ORDER, datmp0, datmp2, datmp1);
+	vm_linear_frac(QUAD_ORDER, a, datmp1, 1, r, 0, 1, datmp0);
+	vm_mul(QUAD_ORDER, datmp0, r1, datmp2);
+	vm_mul(QUAD_ORDER, datmp2, alphaInf, datmp0);
+	vm_div(QUAD_ORDER, datmp1, datmp0, datmp2);
+	double BzDiff = vm_dot(QUAD_ORDER, w, 1, datmp2, 1) * (z - h);
+	stats_time(STATS_T_FACE1, t0);
+	t0 = stats_now();
+
+	/* Second iteration. */
+	h = sol->b2; // DIFF
+
+	/* Preparation of common parameters.
+	 * r1sq = (a + r) ** 2 + (z - h) ** 2	| make this
+	 * r2sq = (a - r) ** 2 + (z - h) ** 2	| make this
+	 * ksq  = 4 * a * r / r1sq				|
+	 * kpsq = r2sq / r1sq					| make this
+	 * csq  = 4 * a * r / (a + r) ** 2		|
+	 * cpsq = (a - r) ** 2 / (a + r) ** 2	| make this
+	 */
+	dtmp = z - h;
+	dtmp *= dtmp;
+	vm_linear_frac(QUAD_ORDER, amrsq, aprsq, 1, dtmp, 1, dtmp, kpsq);
+	vm_sqrt(QUAD_ORDER, kpsq, kp);
+	vm_div(QUAD_ORDER, amrsq, aprsq, cpsq);
+	vm_copy(QUAD_ORDER, aprsq, 1, r1sq, 1);
+	vm_axpy(QUAD_ORDER, 1, &dtmp, 0, r1sq, 1);
+	vm_sqrt(QUAD_ORDER, r1sq, r1);
+
+	/* Calculation of initial values of iterative methods.
+	 * alpha0	= 1							|
+	 * beta0	= kp						|
+	 * S0		= ksq						| not needed
+	 * SG		= 0							|
+	 * delta0	= cpsq / kp					|
+	 * epsilon0 = csq / cpsq				|
+	 * zeta0    = 0							|
+	 */
+	beta0a = kp;
+	vm_linear_frac(QUAD_ORDER, cpsq, kp, 1, 0, 1, 0, delta0a);
+	vm_linear_frac(QUAD_ORDER, cpsq, cpsq, -1, 1, 1, 0, epsilon0a);
+
+	for (int i = 0; i < QUAD_ORDER; ++i)
+	{
+		/* Initialization of iterative method. */
+		double alpha = 1;
+		double beta = beta0a[i];
+		double delta = delta0a[i];
+		double epsilon = epsilon0a[i];
+		double zeta = 0;
+		double SG = 0;
+
+		/* Main iterative loop.
+		 * alphaNext = AM(alpha, beta)
+		 * betaNext = GM(alpha, beta)
+		 * deltaNext = (betaNext / (4 * alphaNext)) * (2 + delta + 1 / delta)
+		 * epsilonNext = delta * (epsilon + zeta) / (1 + delta)
+		 * zetaNext = AM(epsilon, zeta)
+		 * Garrett's Sum = SIGMA_i_0_to_inf(2 ** (i - 1) * (alpha - beta) ** 2)
+		 */
+		int j = 0;
+		double error = 1;
+		while (1)
+		{
+			/* Update Garrett's sum. */
+			double temp = (alpha - beta);
+			temp *= temp;
+			temp *= double(1 << j);
+			SG += temp;
+			if (error < ERROR_REF && abs(1 - delta) < ERROR_REF) break;
+
+			/* Evaluate the error. */
+			error = temp;
+
+			/* Update iterative variables. */
+			temp = sqrt(alpha * beta);
+			alpha = (alpha + beta) * 0.5;
+			beta = temp;
+			temp = (epsilon + zeta) / 2;
+			epsilon = (delta * epsilon + zeta) / (1 + delta);
+			zeta = temp;
+			delta = (2 + delta + 1 / delta) * beta / (4 * alpha);
+
+			++j;
+		}
+
+		alphaInf[i] = alpha;
+		zetaInf[i] = zeta;
+		SGInf[i] = SG * 0.5;
+		if (st != NULL)
+			++st->agm[stats_agm_bin(j)];
+	}
+
+	/* Calculation of B. */
+	vm_mul(QUAD_ORDER, w, r1, datmp0);
+	vm_div(QUAD_ORDER, SGInf, alphaInf, datmp1);
+	BrDiff += vm_dot(QUAD_ORDER, datmp0, 1, datmp1, 1); // DIFF
+	
+	vm_add(QUAD_ORDER, a, a, datmp0);
+	vm_linear_frac(QUAD_ORDER, a, datmp0, 1, -r, 0, 1, datmp1);
+	vm_mul(QUAD_ORDER, datmp1, zetaInf, datmp2);
+	vm_add(QUAD_ORDER, datmp0, datmp2, datmp1);
+	vm_linear_frac(QUAD_ORDER, a, datmp1, 1, r, 0, 1, datmp0);
+	vm_mul(QUAD_ORDER, datmp0, r1, datmp2);
+	vm_mul(QUAD_ORDER, datmp2, alphaInf, datmp0);
+	vm_div(QUAD_ORDER, datmp1, datmp0, datmp2);
+	BzDiff -= vm_dot(QUAD_ORDER, w, 1, datmp2, 1) * (z - h); // DIFF
+	stats_time(STATS_T_FACE2, t0);
+
+	mag_field_2d_t ans;
+    ans.Br = BrDiff;
+    ans.Bz = BzDiff;
+    return ans;
+}
+
+/* Batch kernel.
+ * A lane holds a single quadrature node of a single end face for a single
+ * probe. Lanes of many probes are packed into a block and the AGM iteration
+ * runs over the whole block at once; converged lanes are masked off and the
+ * block stops when every lane has converged. */
+typedef struct _lane_block_t
+{
+	int n;
+	int kernel;		/* SOLB_KERNEL_* */
+	double tol;		/* AGM convergence of the tier */
+	int steps;		/* Carlson steps of the tier */
+	int f32;		/* AGM iteration of the tier in float */
+	double a[BATCH_LANES];	/* Quadrature node (radius of current sheet) */
+	double r[BATCH_LANES];	/* Radial coordinate of the probe */
+	double dz[BATCH_LANES];	/* z - h */
+	double wr[BATCH_LANES];	/* Signed weight of radial component */
+	double wz[BATCH_LANES];	/* Signed weight of axial component */
+	size_t idx[BATCH_LANES];	/* Destination probe */
+	double *gBr;			/* Destination of dBr/dz, if not NULL */
+	double *gBz;			/* Destination of dBz/dz, if not NULL */
+} lane_block_t;
+
+/* Empty block of the kernel and the convergence of the tier. */
+static inline void
+lane_block_init(lane_block_t *blk, int kernel, int tier, double *gBr, double *gBz)
+{
+	blk->n = 0;
+	blk->kernel = kernel;
+	blk->tol = solb_tiers[tier].agm;
+	blk->steps = solb_tiers[tier].steps;
+	blk->f32 = solb_tiers[tier].f32;
+	blk->gBr = gBr;
+	blk->gBz = gBz;
+}
+
+/* Limits of a lane whose AGM has converged; returns alpha and sets zeta.
+ * Once alpha and beta have met, the iteration of delta, epsilon and zeta is
+ * a fixed averaging, whose limit is
+ * zeta = (zeta + sqrt(delta) * epsilon) / (1 + sqrt(delta)).
+ * Iterating on would only take log(delta) towards 0 by about log(4) per
+ * step, and lanes with a close to r start at delta of 1e-10 and below. The
+ * limit is taken after a further step, which leaves alpha and beta apart by
+ * the square of what the convergence test of the tier allows. */
+static inline double
+lane_agm_close(double alpha, double beta, double delta, double epsilon,
+		double zeta, double *zetaInf)
+{
+	double alphaNext = (alpha + beta) * 0.5;
+	double betaNext = sqrt(alpha * beta);
+	double dp1 = 1 + delta;
+	double epsilonNext = (delta * epsilon + zeta) / dp1;
+	double zetaNext = (epsilon + zeta) * 0.5;
+	double sd = sqrt(dp1 * dp1 * betaNext / (4 * alphaNext * delta));
+	*zetaInf = (zetaNext + sd * epsilonNext) / (1 + sd);
+	return alphaNext;
+}
+
+/* Axial derivatives of a lane from K and E of its end face. Differentiating
+ * the sheet under the integral over z leaves the field of the current loop
+ * at the face, per unit current
+ * Bz = mu0 / (2 * pi * r1) * (K + (a ** 2 - r ** 2 - (z - h) ** 2) / r2sq * E)
+ * Br = mu0 * (z - h) / (2 * pi * r * r1) * (-K + (a ** 2 + r ** 2 + (z - h) ** 2) / r2sq * E)
+ * where, with wr = -wz * 0.5 / r and SG / alpha = 2 / pi * ((2 - ksq) * K - 2 * E),
+ * the radial one is free of the cancellation of -K + E near the axis. */
+static inline void
+lane_grad(double a, double r, double dz, double r1, double K, double E,
+		double sga, double wr, double wz, double *gBr, double *gBz)
+{
+	double r1sq = r1 * r1;
+	double r2sq = (a - r) * (a - r) + dz * dz;
+	double r2inv = 1 / r2sq;
+	double c = 2 / M_PI / r1;
+	*gBz = wz * c * (K + ((a - r) * (a + r) - dz * dz) * r2inv * E);
+	*gBr = c * dz * (M_PI / 2 * sga * wr + 2 * a * wz * (E * r2inv - K / r1sq));
+}
+
+/* Elliptic integrals of every lane by Garrett's AGM iteration. A lane stops
+ * once alpha and beta have met, see lane_agm_close(). */
+static void
+lane_kernel_agm(const lane_block_t *blk, int nl, double *dBr, double *dBz,
+		double *gBr, double *gBz)
+{
+	/* Preparation of common parameters; see solb_internal(). With
+	 * r2 = sqrt(amrsq + (z - h) ** 2), all of
+	 * kp		= r2 / r1
+	 * delta0	= cpsq / kp = amrsq * r1 / (aprsq * r2)
+	 * epsilon0	= csq / cpsq = 4 * a * r / amrsq
+	 * share a single division. */
+	double r1[BATCH_LANES];
+	double alpha[BATCH_LANES];
+	double beta[BATCH_LANES];
+	double delta[BATCH_LANES];
+	double epsilon[BATCH_LANES];
+	double zeta[BATCH_LANES];
+	double SG[BATCH_LANES];
+	double error[BATCH_LANES];
+	long active[BATCH_LANES];
+	long iter[BATCH_LANES];
+#pragma omp simd
+	for (int l = 0; l < nl; ++l)
+	{
+		double a = blk->a[l];
+		double r = blk->r[l];
+		double aprsq = (a + r) * (a + r);
+		double amrsq = (a - r) * (a - r);
+		double dzsq = blk->dz[l] * blk->dz[l];
+		double r1l = sqrt(aprsq + dzsq);
+		double r2l = sqrt(amrsq + dzsq);
+		double p = r1l * aprsq;
+		double q = r2l * amrsq;
+		double inv = 1 / (p * q);
+		r1[l] = r1l;
+		alpha[l] = 1;
+		beta[l] = r2l * q * aprsq * inv;
+		delta[l] = amrsq * amrsq * r1l * r1l * inv;
+		epsilon[l] = 4 * a * r * p * r2l * inv;
+		zeta[l] = 0;
+		SG[l] = 0;
+		error[l] = 1;
+		active[l] = 1;
+		iter[l] = 0;
+	}
+
+	/* Main iterative loop, masked per lane. */
+	double tol = blk->tol;
+	int stats = stats_enabled;
+	double scale = 1;
+	while (1)
+	{
+		long any = 0;
+#pragma omp simd reduction(|:any)
+		for (int l = 0; l < nl; ++l)
+		{
+			double temp = (alpha[l] - beta[l]);
+			temp *= temp;
+			temp *= scale;
+			SG[l] = active[l] ? SG[l] + temp : SG[l];
+			/* Written so that a lane gone NaN counts as converged. */
+			long done = !(error[l] >= tol);
+			active[l] = active[l] && !done;
+
+			/* A single division per iteration;
+			 * deltaNext = (1 + delta) ** 2 * betaNext / (4 * alphaNext * delta) */
+			double alphaNext = (alpha[l] + beta[l]) * 0.5;
+			double betaNext = sqrt(alpha[l] * beta[l]);
+			double dp1 = 1 + delta[l];
+			double den = 4 * alphaNext * delta[l];
+			double inv = 1 / (den * dp1);
+			double epsilonNext = (delta[l] * epsilon[l] + zeta[l]) * den * inv;
+			double zetaNext = (epsilon[l] + zeta[l]) * 0.5;
+			double deltaNext = dp1 * betaNext * dp1 * (dp1 * inv);
+			error[l] = active[l] ? temp : error[l];
+			alpha[l] = active[l] ? alphaNext : alpha[l];
+			beta[l] = active[l] ? betaNext : beta[l];
+			epsilon[l] = active[l] ? epsilonNext : epsilon[l];
+			zeta[l] = active[l] ? zetaNext : zeta[l];
+			delta[l] = active[l] ? deltaNext : delta[l];
+			any |= active[l];
+		}
+		if (!any) break;
+		scale *= 2;
+
+		/* Counted apart, so that the loop above is the same without stats. */
+		if (stats)
+		{
+#pragma omp simd
+			for (int l = 0; l < nl; ++l)
+				iter[l] += active[l];
+		}
+	}
+	if (stats)
+	{
+		stats_t *st = stats_local();
+		for (int l = 0; l < blk->n; ++l)
+			++st->agm[stats_agm_bin(iter[l])];
+	}
+
+	/* Calculation of B. */
+#pragma omp simd
+	for (int l = 0; l < nl; ++l)
+	{
+		double a = blk->a[l];
+		double r = blk->r[l];
+		double den = (a + r) * r1[l];
+		alpha[l] = lane_agm_close(alpha[l], beta[l], delta[l], epsilon[l], zeta[l], &zeta[l]);
+		double inv = 1 / (den * alpha[l]);
+		dBr[l] = blk->wr[l] * SG[l] * 0.5 * den * r1[l] * inv;
+		dBz[l] = blk->wz[l] * blk->dz[l] * (2 * a + (a - r) * zeta[l]) * inv;
+	}
+
+	/* Calculation of dB/dz; K = pi / (2 * alpha). */
+	if (gBr == NULL)
+		return;
+#pragma omp simd
+	for (int l = 0; l < nl; ++l)
+	{
+		double a = blk->a[l];
+		double r = blk->r[l];
+		double ksq = 4 * a * r / (r1[l] * r1[l]);
+		double sga = SG[l] * 0.5 / alpha[l];
+		double K = M_PI / 2 / alpha[l];
+		double E = ((2 - ksq) * K - M_PI / 2 * sga) * 0.5;
+		lane_grad(a, r, blk->dz[l], r1[l], K, E, sga, blk->wr[l], blk->wz[l],
+				&gBr[l], &gBz[l]);
+	}
+}
+
+/* Elliptic integrals of every lane by the AGM iteration in float, for the
+ * single tier. Whatever cancels is taken in double: (a - r) ** 2 and the
+ * starting values, which hold all of it, and the closing terms, of which
+ * (2 * a + (a - r) * zeta) gathers zeta of order 1 / (a - r) ** 2. The
+ * iteration itself only takes means of positive numbers, so it loses no
+ * more than a few ulps of float. Means of floats a few ulps apart may cycle
+ * instead of meeting, so that the scaled correction of Garrett's sum never
+ * falls below the tolerance; a lane stops once alpha and beta agree within
+ * the tolerance of the tier, and zeta is closed as in lane_kernel_agm().
+ * Graded nodes put a within 1e-10 of r, where epsilon starts near 1e20 and
+ * delta swings to 1e19 after a step. The iteration of epsilon and zeta is
+ * linear, so epsilon starts at 1 and its starting value scales zeta once
+ * closed; a step takes two divisions, so that delta squared is never
+ * formed. */
+static void
+lane_kernel_agm_f32(const lane_block_t *blk, int nl, double *dBr, double *dBz)
+{
+	double r1[BATCH_LANES];
+	double epsilon0[BATCH_LANES];
+	float alpha[BATCH_LANES];
+	float beta[BATCH_LANES];
+	float delta[BATCH_LANES];
+	float epsilon[BATCH_LANES];
+	float zeta[BATCH_LANES];
+	float SG[BATCH_LANES];
+	int active[BATCH_LANES];
+	int iter[BATCH_LANES];
+#pragma omp simd
+	for (int l = 0; l < nl; ++l)
+	{
+		double a = blk->a[l];
+		double r = blk->r[l];
+		double aprsq = (a + r) * (a + r);
+		double amrsq = (a - r) * (a - r);
+		double dzsq = blk->dz[l] * blk->dz[l];
+		double r1l = sqrt(aprsq + dzsq);
+		double r2l = sqrt(amrsq + dzsq);
+		double p = r1l * aprsq;
+		double q = r2l * amrsq;
+		double inv = 1 / (p * q);
+		r1[l] = r1l;
+		alpha[l] = 1;
+		beta[l] = r2l * q * aprsq * inv;
+		delta[l] = amrsq * amrsq * r1l * r1l * inv;
+		epsilon0[l] = 4 * a * r * p * r2l * inv;
+		epsilon[l] = 1;
+		zeta[l] = 0;
+		SG[l] = 0;
+		active[l] = 1;
+		iter[l] = 0;
+	}
+
+	/* Main iterative loop, masked per lane; see lane_kernel_agm(). */
+	float tol = blk->tol;
+	int stats = stats_enabled;
+	float scale = 1;
+	for (int j = 0; j < AGM_F32_MAX; ++j)
+	{
+		int any = 0;
+#pragma omp simd reduction(|:any)
+		for (int l = 0; l < nl; ++l)
+		{
+			float temp = (alpha[l] - beta[l]);
+			temp *= temp;
+			temp *= scale;
+			SG[l] = active[l] ? SG[l] + temp : SG[l];
+			int done = !(fabsf(alpha[l] - beta[l]) >= tol * alpha[l]);
+			active[l] = active[l] && !done;
+
+			float alphaNext = (alpha[l] + beta[l]) * 0.5f;
+			float betaNext = sqrtf(alpha[l] * beta[l]);
+			float dp1 = 1 + delta[l];
+			float den = 4 * alphaNext * delta[l];
+			float epsilonNext = (delta[l] * epsilon[l] + zeta[l]) / dp1;
+			float zetaNext = (epsilon[l] + zeta[l]) * 0.5f;
+			float deltaNext = dp1 * betaNext * (dp1 / den);
+			alpha[l] = active[l] ? alphaNext : alpha[l];
+			beta[l] = active[l] ? betaNext : beta[l];
+			epsilon[l] = active[l] ? epsilonNext : epsilon[l];
+			zeta[l] = active[l] ? zetaNext : zeta[l];
+			delta[l] = active[l] ? deltaNext : delta[l];
+			any |= active[l];
+		}
+		if (!any) break;
+		scale *= 2;
+		if (stats)
+		{
+#pragma omp simd
+			for (int l = 0; l < nl; ++l)
+				iter[l] += active[l];
+		}
+	}
+	if (stats)
+	{
+		stats_t *st = stats_local();
+		for (int l = 0; l < blk->n; ++l)
+			++st->agm[stats_agm_bin(iter[l])];
+	}
+
+	/* Calculation of B. */
+#pragma omp simd
+	for (int l = 0; l < nl; ++l)
+	{
+		double a = blk->a[l];
+		double r = blk->r[l];
+		double den = (a + r) * r1[l];
+		double z;
+		double alphaInf = lane_agm_close(alpha[l], beta[l], delta[l], epsilon[l], zeta[l], &z);
+		double inv = 1 / (den * alphaInf);
+		z *= epsilon0[l];
+		dBr[l] = blk->wr[l] * SG[l] * 0.5 * den * r1[l] * inv;
+		dBz[l] = blk->wz[l] * blk->dz[l] * (2 * a + (a - r) * z) * inv;
+	}
+}
+
+/* Closing terms of Carlson's R_F(x, y, z) and R_D(x, y, z) after the
+ * duplication steps; fifth order series of the symmetric integrals. */
+static inline double
+carlson_rf_series(double x, double y, double z)
+{
+	double A = (x + y + z) * (1.0 / 3);
+	double ainv = 1 / A;
+	double X = 1 - x * ainv;
+	double Y = 1 - y * ainv;
+	double Z = -(X + Y);
+	double E2 = X * Y - Z * Z;
+	double E3 = X * Y * Z;
+	return (1 - E2 * (1.0 / 10) + E3 * (1.0 / 14) + E2 * E2 * (1.0 / 24)
+			- E2 * E3 * (3.0 / 44)) / sqrt(A);
+}
+
+static inline double
+carlson_rd_series(double x, double y, double z)
+{
+	double A = (x + y + 3 * z) * 0.2;
+	double ainv = 1 / A;
+	double X = 1 - x * ainv;
+	double Y = 1 - y * ainv;
+	double Z = -(X + Y) * (1.0 / 3);
+	double E2 = X * Y - 6 * Z * Z;
+	double E3 = (3 * X * Y - 8 * Z * Z) * Z;
+	double E4 = 3 * (X * Y - Z * Z) * Z * Z;
+	double E5 = X * Y * Z * Z * Z;
+	return (1 - E2 * (3.0 / 14) + E3 * (1.0 / 6) + E2 * E2 * (9.0 / 88)
+			- E4 * (3.0 / 22) - E2 * E3 * (9.0 / 52) + E5 * (3.0 / 26))
+		* ainv / sqrt(A);
+}
+
+/* Elliptic integrals of every lane in closed form by Carlson's symmetric
+ * integrals. Every lane takes the same duplication steps, CARLSON_STEPS in
+ * the full tier, so that no lane is masked and the work per block is fixed.
+ * K		= R_F(0, kpsq, 1)
+ * K - E	= ksq / 3 * R_D(0, kpsq, 1)
+ * SG / alpha	= 2 / pi * ((2 - ksq) * K - 2 * E)
+ *		= 2 / pi * ksq * (2 / 3 * R_D - R_F)
+ * The third kind enters through Heuman's Lambda_0(eps, k), sin(eps) ** 2 =
+ * cpsq / kpsq, which takes F and E of the complementary modulus and leaves
+ * (z - h) * (a - r) / (a + r) * Pi(csq, k) / r1
+ *	= (z - h) * (a - r) / (a + r) * K / r1
+ *	+ sgn(a - r) * sgn(z - h) * pi / 2 * (1 - Lambda_0)
+ * so that R_J and the inverse trigonometric R_C are never needed. */
+static void
+lane_kernel_carlson(const lane_block_t *blk, int nl, double *dBr, double *dBz,
+		double *gBr, double *gBz)
+{
+	/* Arguments (0, kpsq, 1) of K and E, and (1 - sin(eps) ** 2, csq, 1) of
+	 * the incomplete integrals of the complementary modulus. */
+	double r1[BATCH_LANES];
+	double ksq[BATCH_LANES];
+	double kpsq[BATCH_LANES];
+	double s2[BATCH_LANES];
+	double sg[BATCH_LANES];
+	double x0[BATCH_LANES];
+	double y0[BATCH_LANES];
+	double z0[BATCH_LANES];
+	double x1[BATCH_LANES];
+	double y1[BATCH_LANES];
+	double z1[BATCH_LANES];
+	double sum0[BATCH_LANES];
+	double sum1[BATCH_LANES];
+#pragma omp simd
+	for (int l = 0; l < nl; ++l)
+	{
+		double a = blk->a[l];
+		double r = blk->r[l];
+		double dz = blk->dz[l];
+		double aprsq = (a + r) * (a + r);
+		double amrsq = (a - r) * (a - r);
+		double dzsq = dz * dz;
+		double r1sq = aprsq + dzsq;
+		double r2sq = amrsq + dzsq;
+		double r1inv = 1 / r1sq;
+		double r2inv = 1 / r2sq;
+		double csq = 4 * a * r / aprsq;
+
+		/* 1 - sin(eps) ** 2 = csq * (z - h) ** 2 / r2sq, free of
+		 * cancellation. On the axis the Lambda_0 term vanishes and the
+		 * lane is kept away from R_F(0, 0, 1). */
+		long offaxis = csq > 0;
+		r1[l] = sqrt(r1sq);
+		ksq[l] = 4 * a * r * r1inv;
+		kpsq[l] = r2sq * r1inv;
+		s2[l] = offaxis ? amrsq * r1sq * r2inv / aprsq : 0;
+		sg[l] = offaxis ? (a > r ? 1 : -1) * ((dz > 0) - (dz < 0)) : 0;
+		x0[l] = 0;
+		y0[l] = kpsq[l];
+		z0[l] = 1;
+		x1[l] = offaxis ? csq * dzsq * r2inv : 1;
+		y1[l] = offaxis ? csq : 1;
+		z1[l] = 1;
+		sum0[l] = 0;
+		sum1[l] = 0;
+	}
+
+	/* Duplication steps of both sets of arguments. */
+	double f = 1;
+	for (int i = 0; i < blk->steps; ++i)
+	{
+#pragma omp simd
+		for (int l = 0; l < nl; ++l)
+		{
+			double sx = sqrt(x0[l]);
+			double sy = sqrt(y0[l]);
+			double sz = sqrt(z0[l]);
+			double lambda = sx * sy + sy * sz + sz * sx;
+			sum0[l] += f / (sz * (z0[l] + lambda));
+			x0[l] = (x0[l] + lambda) * 0.25;
+			y0[l] = (y0[l] + lambda) * 0.25;
+			z0[l] = (z0[l] + lambda) * 0.25;
+
+			sx = sqrt(x1[l]);
+			sy = sqrt(y1[l]);
+			sz = sqrt(z1[l]);
+			lambda = sx * sy + sy * sz + sz * sx;
+			sum1[l] += f / (sz * (z1[l] + lambda));
+			x1[l] = (x1[l] + lambda) * 0.25;
+			y1[l] = (y1[l] + lambda) * 0.25;
+			z1[l] = (z1[l] + lambda) * 0.25;
+		}
+		f *= 0.25;
+	}
+
+	/* Calculation of B. */
+#pragma omp simd
+	for (int l = 0; l < nl; ++l)
+	{
+		double a = blk->a[l];
+		double r = blk->r[l];
+		double dz = blk->dz[l];
+		double K = carlson_rf_series(x0[l], y0[l], z0[l]);
+		double RD = 3 * sum0[l] + f * carlson_rd_series(x0[l], y0[l], z0[l]);
+		double RFe = carlson_rf_series(x1[l], y1[l], z1[l]);
+		double RDe = 3 * sum1[l] + f * carlson_rd_series(x1[l], y1[l], z1[l]);
+
+		double s = sqrt(s2[l]);
+		double F = s * RFe;
+		double Ee = F - kpsq[l] * (1.0 / 3) * s * s2[l] * RDe;
+		double lambda0 = 2 / M_PI * (K * Ee - ksq[l] * (1.0 / 3) * RD * F);
+
+		dBr[l] = blk->wr[l] * r1[l] * (2 / M_PI) * ksq[l] * (2.0 / 3 * RD - K);
+		dBz[l] = blk->wz[l] * (4 / M_PI * a * dz * K / ((a + r) * r1[l])
+				+ sg[l] * (1 - lambda0));
+
+		/* Calculation of dB/dz; K - E = ksq / 3 * R_D. */
+		if (gBr != NULL)
+		{
+			double sga = 2 / M_PI * ksq[l] * (2.0 / 3 * RD - K);
+			lane_grad(a, r, dz, r1[l], K, K - ksq[l] * (1.0 / 3) * RD, sga,
+					blk->wr[l], blk->wz[l], &gBr[l], &gBz[l]);
+		}
+	}
+}
+
+static void
+lane_block_eval(lane_block_t *blk, double *Br, double *Bz)
+{
+	/* Pad idle lanes with a trivially converging configuration. */
+	int nl = (blk->n + LANE_PAD - 1) / LANE_PAD * LANE_PAD;
+	for (int l = blk->n; l < nl; ++l)
+	{
+		blk->a[l] = 1;
+		blk->r[l] = 0;
+		blk->dz[l] = 1;
+		blk->wr[l] = 0;
+		blk->wz[l] = 0;
+	}
+
+	/* Contributions are gathered in lane order. */
+	double dBr[BATCH_LANES];
+	double dBz[BATCH_LANES];
+	double gBr[BATCH_LANES];
+	double gBz[BATCH_LANES];
+	int grad = blk->gBr != NULL;
+	unsigned long long t0 = stats_now();
+	if (blk->kernel == SOLB_KERNEL_CARLSON)
+		lane_kernel_carlson(blk, nl, dBr, dBz, grad ? gBr : NULL, gBz);
+	else if (blk->f32 && !grad)
+		lane_kernel_agm_f32(blk, nl, dBr, dBz);
+	else
+		lane_kernel_agm(blk, nl, dBr, dBz, grad ? gBr : NULL, gBz);
+	if (stats_enabled)
+	{
+		stats_t *st = stats_local();
+		st->time[STATS_T_KERNEL] += stats_now() - t0;
+		++st->count[STATS_BLOCKS];
+		st->count[STATS_LANES] += blk->n;
+		st->count[STATS_LANES_PAD] += nl - blk->n;
+	}
+
+	/* Lanes of a probe are contiguous; accumulate them before the store. */
+	size_t cur = blk->idx[0];
+	double accr = 0;
+	double accz = 0;
+	double accgr = 0;
+	double accgz = 0;
+	for (int l = 0; l < blk->n; ++l)
+	{
+		if (blk->idx[l] != cur)
+		{
+			Br[cur] += accr;
+			Bz[cur] += accz;
+			if (grad)
+			{
+				blk->gBr[cur] += accgr;
+				blk->gBz[cur] += accgz;
+			}
+			cur = blk->idx[l];
+			accr = 0;
+			accz = 0;
+			accgr = 0;
+			accgz = 0;
+		}
+		accr += dBr[l];
+		accz += dBz[l];
+		if (grad)
+		{
+			accgr += gBr[l];
+			accgz += gBz[l];
+		}
+	}
+	Br[cur] += accr;
+	Bz[cur] += accz;
+	if (grad)
+	{
+		blk->gBr[cur] += accgr;
+		blk->gBz[cur] += accgz;
+	}
+	blk->n = 0;
+}
+
+/* Append a single lane, running the block whenever it fills. */
+static inline void
+lane_block_lane(lane_block_t *blk, double a, double r, double dz,
+		double wr, double wz, size_t idx, double *Br, double *Bz)
+{
+	int l = blk->n++;
+	blk->a[l] = a;
+	blk->r[l] = r;
+	blk->dz[l] = dz;
+	blk->wr[l] = wr;
+	blk->wz[l] = wz;
+	blk->idx[l] = idx;
+	if (blk->n == BATCH_LANES)
+		lane_block_eval(blk, Br, Bz);
+}
+
+/* Least semi-major axis, in half widths of (a1, a2), of the Bernstein
+ * ellipse through the nearest singularity for which every order of
+ * TIER_LADDER meets the tolerance of a tier; rho ** -2N / (1 - rho ** -2) <=
+ * tol, as in adapt_segment(). */
+typedef struct _tier_reach_t
+{
+	double A[SOLB_NTIER][TIER_LADDER];
+} tier_reach_t;
+
+static tier_reach_t
+tier_reach_build()
+{
+	tier_reach_t t;
+	for (int k = 0; k < SOLB_NTIER; ++k)
+	{
+		double tol = solb_tiers[k].tol;
+		for (int m = 0; m < TIER_LADDER; ++m)
+		{
+			if (!(tol > 0))
+			{
+				t.A[k][m] = INFINITY;
+				continue;
+			}
+
+			/* Bisection over log(rho). */
+			double lo = 0;
+			double hi = 64;
+			for (int it = 0; it < 100; ++it)
+			{
+				double mid = (lo + hi) * 0.5;
+				double rho = exp(mid);
+				if (pow(rho, -2.0 * tier_orders[m]) / (1 - 1 / (rho * rho)) > tol)
+					lo = mid;
+				else
+					hi = mid;
+			}
+			double rho = exp(hi);
+			t.A[k][m] = (rho + 1 / rho) * 0.5;
+		}
+	}
+	return t;
+}
+
+static const tier_reach_t &
+tier_reach()
+{
+	static const tier_reach_t t = tier_reach_build();
+	return t;
+}
+
+/* Quadrature state of a single coil along a column of probes at radius r;
+ * nodes and weights, split at r within the winding. */
+typedef struct _lane_column_t
+{
+	double r;
+	double rinv;			/* Note 1 of solb_single() */
+	int fine;				/* Column of the fine tier; see solb_tiers */
+	int split;				/* Split at r, within the winding or beside it */
+	int order[2];			/* Nodes of each radial segment at the compiled order */
+	int n;					/* Nodes over both radial segments */
+	double a[2 * QUAD_ORDER_MAX];
+	double wr[2 * QUAD_ORDER_MAX];	/* Radial weight of the b1 face */
+	double wz[2 * QUAD_ORDER_MAX];	/* Axial weight of the b1 face */
+	double ga[2 * QUAD_ORDER_MAX];	/* Nodes graded towards r, of the fine tier */
+	double gwr[2 * QUAD_ORDER_MAX];
+	double gwz[2 * QUAD_ORDER_MAX];
+	double len[2];			/* Radial segments, signed; see lane_column_init() */
+	double grade[2];		/* Distance to an end face within which a segment is graded */
+	const double *reach;	/* Reach of the orders of the tier, or NULL */
+} lane_column_t;
+
+/* Nodes and axial weights of the radial segment s, (a1, r) or (r, a2), of a
+ * split column at a given order; uniform, or graded towards r by
+ * a = r -+ len * t ** 2, t in (0, 1). Beside the winding one segment runs
+ * backwards, and its weights are negated. */
+static inline void
+lane_segment_nodes(const solb_coil_t *coil, double r, int s, int order, int graded,
+		double *a, double *wz)
+{
+	if (order == 0)
+		return;
+	const double *xq = gl_nodes(order);
+	const double *wq = gl_weights(order);
+	double lo = s ? r : coil->a1;
+	double hi = s ? coil->a2 : r;
+	double mid = (lo + hi) * 0.5;
+	double hw = (hi - lo) * 0.5;
+	double len = hi - lo;
+	double c = coil->c * len;
+	for (int i = 0; i < order; ++i)
+	{
+		double t = (1 + xq[i]) * 0.5;
+		a[i] = graded ? r + (s ? len : -len) * t * t : mid + hw * xq[i];
+		wz[i] = graded ? wq[i] * c * 2 * t : wq[i] * c;
+	}
+}
+
+/* Lowest order of TIER_LADDER whose reach the Bernstein ellipse of semi-major
+ * axis A exceeds; the highest if none does. */
+static inline int
+tier_order(const double *reach, double A)
+{
+	int k = 0;
+	while (k < TIER_LADDER - 1 && A < reach[k])
+		++k;
+	return tier_orders[k];
+}
+
+static void
+lane_column_init(lane_column_t *col, const solb_coil_t *coil, double r)
+{
+	double a1 = coil->a1;
+	double a2 = coil->a2;
+
+	/* Note 1 of solb_single(). */
+	double rinv = (r / a1 < NEAR_CENTER_THRESHOLD) ? 0 : 0.5 / r;
+
+	col->r = r;
+	col->rinv = rinv;
+	col->n = 0;
+	col->reach = coil->tier != SOLB_TIER_FULL ? tier_reach().A[coil->tier] : NULL;
+	col->fine = solb_tiers[coil->tier].fine;
+	double band = col->fine ? GRADE_REACH * (a2 - a1) : 0;
+	col->split = r > a1 - band && r < a2 + band;
+	if (col->split)
+	{
+		/* Probes within the radial extent of the winding split the radial
+		 * integral at r. In the fine tier, the integrand is nearly singular at
+		 * a = r + i (z - h) for probes close to an end face; those take the
+		 * nodes of a segment graded towards r, see lane_column_push(). Between
+		 * the end faces, the terms of both faces jump at a = r alike, so that
+		 * probes just beside the winding split at r as well: the integral over
+		 * (a1, a2) is that over (a1, r) and (r, a2), one of which runs
+		 * backwards. A segment of no length takes no nodes. */
+		int n = 0;
+		for (int s = 0; s < 2; ++s)
+		{
+			col->len[s] = s ? a2 - r : r - a1;
+			col->grade[s] = col->fine ? GRADE_REACH * fabs(col->len[s]) : 0;
+			col->order[s] = col->len[s] != 0 ? coil->order : 0;
+			lane_segment_nodes(coil, r, s, col->order[s], 0, col->a + n, col->wz + n);
+			if (col->fine)
+				lane_segment_nodes(coil, r, s, col->order[s], 1, col->ga + n, col->gwz + n);
+			n += col->order[s];
+		}
+		col->n = n;
+	}
+	else
+	{
+		col->order[0] = coil->order;
+		col->order[1] = 0;
+		for (int i = 0; i < coil->order; ++i)
+		{
+			col->a[col->n] = coil->a[i];
+			col->wz[col->n++] = coil->w[i];
+		}
+	}
+	for (int i = 0; i < col->n; ++i)
+		col->wr[i] = -col->wz[i] * rinv;
+	if (col->fine)
+	{
+		for (int i = 0; i < col->n; ++i)
+			col->gwr[i] = -col->gwz[i] * rinv;
+	}
+}
+
+/* Push the lanes of n nodes of a single probe, running the block whenever
+ * it fills. Lanes of the two end faces are interleaved node by node; the b2
+ * face takes the weights of b1 negated. A probe that does not fit starts a
+ * block of its own, so that its lanes are summed alike wherever it falls in
+ * a run of probes. */
+static inline void
+lane_nodes_push(lane_block_t *blk, int n, const double *a, const double *wr,
+		const double *wz, double r, const double *dz, size_t idx, double *Br,
+		double *Bz)
+{
+	if (blk->n > 0 && blk->n + 2 * n > BATCH_LANES)
+		lane_block_eval(blk, Br, Bz);
+	for (int i = 0; i < n; ++i)
+	{
+		for (int f = 0; f < 2; ++f)
+		{
+			int l = blk->n++;
+			blk->a[l] = a[i];
+			blk->r[l] = r;
+			blk->dz[l] = dz[f];
+			blk->wr[l] = f ? -wr[i] : wr[i];
+			blk->wz[l] = f ? -wz[i] : wz[i];
+			blk->idx[l] = idx;
+			if (blk->n == BATCH_LANES)
+				lane_block_eval(blk, Br, Bz);
+		}
+	}
+}
+
+/* Push every lane of a single probe of a column. In a relaxed tier every
+ * radial segment takes the lowest order whose reach the Bernstein ellipse
+ * through the singularity a = r + i|z - h| of the nearer end face exceeds,
+ * up to the compiled order; the fine tier takes that order when it is above
+ * the compiled one. The semi-major axis of that ellipse is half the sum of
+ * the distances from the singularity to the ends of the segment, in half
+ * widths. A segment graded by a = r -+ len * t ** 2 has its singularity at
+ * t = sqrt(i |z - h| / len) instead. Between the end faces, the integrand of
+ * a column that is not split jumps at a = r, so that its ellipse runs
+ * through r. A column beside the winding is split only while r is nearer
+ * the winding than z is to an end face. The Jacobian keeps the compiled
+ * order, see solb_eval_grad_batch(). */
+static inline void
+lane_column_push(lane_block_t *blk, const lane_column_t *col,
+		const solb_coil_t *coil, double z, size_t idx, double *Br, double *Bz)
+{
+	double dz[2] = { z - coil->b1, z - coil->b2 };
+	double d = std::min(fabs(dz[0]), fabs(dz[1]));
+	int inside = col->r > coil->a1 && col->r < coil->a2;
+	int between = dz[0] * dz[1] < 0;
+	double side = std::max(coil->a1 - col->r, col->r - coil->a2);
+	int split = col->split && (inside || side < d);
+	const double *reach = blk->gBr == NULL ? col->reach : NULL;
+
+	/* A segment is graded only within GRADE_REACH of its length from an end
+	 * face; farther off, uniform nodes are the more accurate. */
+	int graded[2] = { split && d < col->grade[0], split && d < col->grade[1] };
+	int base[2] = { split ? col->order[0] : coil->order, split ? col->order[1] : 0 };
+	int order[2] = { base[0], base[1] };
+	double A[2] = { INFINITY, INFINITY };
+	if (reach != NULL && split)
+	{
+		for (int s = 0; s < 2; ++s)
+		{
+			double v = d / fabs(col->len[s]);
+			A[s] = graded[s] ? sqrt(v) + sqrt(v - sqrt(2 * v) + 1) : v + sqrt(1 + v * v);
+		}
+	}
+	else if (reach != NULL)
+	{
+		double d1 = col->r - coil->a1;
+		double d2 = col->r - coil->a2;
+		double e = between ? 0 : d;
+		A[0] = (sqrt(d1 * d1 + e * e) + sqrt(d2 * d2 + e * e)) / (coil->a2 - coil->a1);
+	}
+	if (reach != NULL)
+	{
+		for (int s = 0; s < 2; ++s)
+		{
+			if (base[s] == 0)
+				continue;
+			int o = tier_order(reach, A[s]);
+			order[s] = col->fine ? std::max(o, base[s]) : std::min(o, base[s]);
+		}
+	}
+
+	/* Nodes of the column where they serve, or of the orders taken */
+	int relaxed = order[0] != base[0] || order[1] != base[1];
+	int n = order[0] + order[1];
+	if (!relaxed && split == col->split && graded[0] == graded[1])
+		lane_nodes_push(blk, n, graded[0] ? col->ga : col->a, graded[0] ? col->gwr : col->wr,
+				graded[0] ? col->gwz : col->wz, col->r, dz, idx, Br, Bz);
+	else
+	{
+		double a[2 * QUAD_ORDER_MAX];
+		double wr[2 * QUAD_ORDER_MAX];
+		double wz[2 * QUAD_ORDER_MAX];
+		if (split)
+		{
+			lane_segment_nodes(coil, col->r, 0, order[0], graded[0], a, wz);
+			lane_segment_nodes(coil, col->r, 1, order[1], graded[1], a + order[0],
+					wz + order[0]);
+		}
+		else
+		{
+			const double *xq = gl_nodes(order[0]);
+			const double *wq = gl_weights(order[0]);
+			double mid = (coil->a1 + coil->a2) * 0.5;
+			double hw = (coil->a2 - coil->a1) * 0.5;
+			double c = coil->c * (coil->a2 - coil->a1);
+			for (int i = 0; i < order[0]; ++i)
+			{
+				a[i] = mid + hw * xq[i];
+				wz[i] = wq[i] * c;
+			}
+		}
+		for (int i = 0; i < n; ++i)
+			wr[i] = -wz[i] * col->rinv;
+		lane_nodes_push(blk, n, a, wr, wz, col->r, dz, idx, Br, Bz);
+	}
+	if (stats_enabled)
+	{
+		stats_t *st = stats_local();
+		++st->count[STATS_PROBES];
+		st->count[STATS_PROBES_INSIDE] += inside;
+		st->count[STATS_PROBES_RELAXED] += relaxed;
+		++st->order[std::max(order[0], order[1])];
+	}
+}
+
+/* Push every lane of a single probe. */
+static void
+lane_block_push(lane_block_t *blk, const solb_coil_t *coil,
+		double r, double z, size_t idx, double *Br, double *Bz)
+{
+	lane_column_t col;
+	lane_column_init(&col, coil, r);
+	lane_column_push(blk, &col, coil, z, idx, Br, Bz);
+}
+
+/*
+ * solb_compile
+ * Validate a solenoid and cache its quadrature state for a Gauss-Legendre
+ * rule of the given order.
+ * returns 1 on success, 0 on failure
+ */
+int
+solb_compile(const top_solenoid_t *sol, solb_coil_t *coil, int order)
+{
+	static const char *label = "solb_compile";
+
+	/* Handle bad inputs. */
+	if (sol == NULL)
+	{
+		fprintf(stderr, "%s: No solenoid has been specified.", label);
+		return 0;
+	}
+	if (sol->a2 < sol->a1 || sol->b2 < sol->b1)
+	{
+		fprintf(stderr, "%s: Wrong solenoid dimension.", label);
+		return 0;
+	}
+	if (order < QUAD_ORDER_MIN || order > QUAD_ORDER_MAX)
+	{
+		fprintf(stderr, "%s: Quadrature order should be in [%d, %d].", label,
+				QUAD_ORDER_MIN, QUAD_ORDER_MAX);
+		return 0;
+	}
+
+	coil->a1 = sol->a1;
+	coil->a2 = sol->a2;
+	coil->b1 = sol->b1;
+	coil->b2 = sol->b2;
+	coil->j = sol->j;
+	coil->c = 0.5e-7 * sol->j * M_PI;
+	coil->order = order;
+	coil->kernel = SOLB_KERNEL_AGM;
+	coil->tier = SOLB_TIER_FULL;
+
+	const double *xq = gl_nodes(order);
+	const double *wq = gl_weights(order);
+	double mid = (sol->a1 + sol->a2) * 0.5;
+	double hw = (sol->a2 - sol->a1) * 0.5;
+	double c = coil->c * (sol->a2 - sol->a1);
+	for (int i = 0; i < order; ++i)
+	{
+		coil->a[i] = mid + hw * xq[i];
+		coil->w[i] = wq[i] * c;
+	}
+	return 1;
+}
+
+/*
+ * solb_set_kernel
+ * Select the elliptic integral kernel used by the evaluations of a compiled
+ * solenoid; either SOLB_KERNEL_AGM or SOLB_KERNEL_CARLSON.
+ * returns 1 on success, 0 on failure
+ */
+int
+solb_set_kernel(solb_coil_t *coil, int kernel)
+{
+	static const char *label = "solb_set_kernel";
+
+	if (kernel != SOLB_KERNEL_AGM && kernel != SOLB_KERNEL_CARLSON)
+	{
+		fprintf(stderr, "%s: Unknown kernel %d.", label, kernel);
+		return 0;
+	}
+
+	coil->kernel = kernel;
+	return 1;
+}
+
+/*
+ * solb_set_tier
+ * Select the accuracy tier of the evaluations of a compiled solenoid;
+ * SOLB_TIER_FULL, SOLB_TIER_PPB, SOLB_TIER_PPM, SOLB_TIER_SINGLE or
+ * SOLB_TIER_FINE. A relaxed tier never takes an order above the one given to
+ * solb_compile(), so it meets its tolerance only where that order does; at
+ * order 8 the relative error within 1 cm of a winding is up to 2.5e-5 in
+ * every tier but the fine one, which stays within 1e-12 there, and 6e-7
+ * within 0.1 mm of an end face.
+ * returns 1 on success, 0 on failure
+ */
+int
+solb_set_tier(solb_coil_t *coil, int tier)
+{
+	static const char *label = "solb_set_tier";
+
+	if (tier < 0 || tier >= SOLB_NTIER)
+	{
+		fprintf(stderr, "%s: Unknown tier %d.", label, tier);
+		return 0;
+	}
+
+	coil->tier = tier;
+	return 1;
+}
+
+/*
+ * solb_tier_parse
+ * Tier of a name; full, ppb, ppm or single.
+ * returns SOLB_TIER_* on success, -1 on failure
+ */
+int
+solb_tier_parse(const char *name)
+{
+	for (int t = 0; t < SOLB_NTIER; ++t)
+	{
+		if (strcmp(name, solb_tiers[t].name) == 0)
+			return t;
+	}
+	return -1;
+}
+
+const char *
+solb_tier_name(int tier)
+{
+	return tier >= 0 && tier < SOLB_NTIER ? solb_tiers[tier].name : "unknown";
+}
+
+mag_field_2d_t
+solb_eval(const solb_coil_t *coil, double r, double z)
+{
+	double Br = 0;
+	double Bz = 0;
+	lane_block_t blk;
+	lane_block_init(&blk, coil->kernel, coil->tier, NULL, NULL);
+	lane_block_push(&blk, coil, r, z, 0, &Br, &Bz);
+	if (blk.n > 0)
+		lane_block_eval(&blk, &Br, &Bz);
+
+	mag_field_2d_t B{Br, Bz};
+
+	return B;
+}
+
+void
+solb_eval_batch(const solb_coil_t *coil, const double *r, const double *z,
+		size_t n, double *Br, double *Bz)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		Br[i] = 0;
+		Bz[i] = 0;
+	}
+
+	/* Consecutive probes of the same radius share a column. */
+	lane_block_t blk;
+	lane_column_t col;
+	lane_block_init(&blk, coil->kernel, coil->tier, NULL, NULL);
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (i == 0 || r[i] != col.r)
+			lane_column_init(&col, coil, r[i]);
+		lane_column_push(&blk, &col, coil, z[i], i, Br, Bz);
+	}
+	if (blk.n > 0)
+		lane_block_eval(&blk, Br, Bz);
+}
+
+/*
+ * solb_eval_column
+ * Field at n probes of a single radius r; the quadrature state of the
+ * column is taken once.
+ */
+void
+solb_eval_column(const solb_coil_t *coil, double r, const double *z,
+		size_t n, double *Br, double *Bz)
+{
+	for (size_t i = 0; i < n; ++i)
+	{
+		Br[i] = 0;
+		Bz[i] = 0;
+	}
+
+	lane_block_t blk;
+	lane_column_t col;
+	lane_block_init(&blk, coil->kernel, coil->tier, NULL, NULL);
+	lane_column_init(&col, coil, r);
+	for (size_t i = 0; i < n; ++i)
+		lane_column_push(&blk, &col, coil, z[i], i, Br, Bz);
+	if (blk.n > 0)
+		lane_block_eval(&blk, Br, Bz);
+}
+
+int
+solb_batch(const top_solenoid_t *sol, const double *r, const double *z,
+		size_t n, double *Br, double *Bz)
+{
+	solb_coil_t coil;
+	if (!solb_compile(sol, &coil))
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			Br[i] = 0;
+			Bz[i] = 0;
+		}
+		return 0;
+	}
+	solb_eval_batch(&coil, r, z, n, Br, Bz);
+	return 1;
+}
+
+/*
+ * solb_eval_grad_batch
+ * Field and its Jacobian at n probes in a single pass. The kernels yield
+ * dBr/dz and dBz/dz from the same elliptic integrals as B; the radial
+ * derivatives follow from the field equations
+ * dBr/dr = -dBz/dz - Br / r and dBz/dr = dBr/dz - mu0 * j,
+ * the current term present only within the winding. On the axis
+ * dBr/dr = -dBz/dz / 2 since Br vanishes as r.
+ */
+void
+solb_eval_grad_batch(const solb_coil_t *coil, const double *r, const double *z,
+		size_t n, mag_field_grad_2d_t *res)
+{
+	std::vector<double> buf(4 * n, 0.0);
+	double *Br = &buf[0];
+	double *Bz = Br + n;
+	double *Brz = Bz + n;
+	double *Bzz = Brz + n;
+
+	lane_block_t blk;
+	lane_column_t col;
+	/* Derivatives are more nearly singular than the field; the Jacobian keeps
+	 * the full tier whatever the tier of the coil. */
+	lane_block_init(&blk, coil->kernel, SOLB_TIER_FULL, Brz, Bzz);
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (i == 0 || r[i] != col.r)
+			lane_column_init(&col, coil, r[i]);
+		lane_column_push(&blk, &col, coil, z[i], i, Br, Bz);
+	}
+	if (blk.n > 0)
+		lane_block_eval(&blk, Br, Bz);
+
+	double mu0j = 4e-7 * M_PI * coil->j;
+	for (size_t i = 0; i < n; ++i)
+	{
+		/* Note 1 of solb_single(). */
+		int axis = r[i] / coil->a1 < NEAR_CENTER_THRESHOLD;
+		int inside = r[i] > coil->a1 && r[i] < coil->a2
+			&& z[i] > coil->b1 && z[i] < coil->b2;
+		res[i].Br = Br[i];
+		res[i].Bz = Bz[i];
+		res[i].dBrdr = axis ? -0.5 * Bzz[i] : -Bzz[i] - Br[i] / r[i];
+		res[i].dBrdz = Brz[i];
+		res[i].dBzdr = inside ? Brz[i] - mu0j : Brz[i];
+		res[i].dBzdz = Bzz[i];
+	}
+}
+
+mag_field_grad_2d_t
+solb_eval_grad(const solb_coil_t *coil, double r, double z)
+{
+	mag_field_grad_2d_t res;
+	solb_eval_grad_batch(coil, &r, &z, 1, &res);
+	return res;
+}
+
+/*
+ * solb_single_grad
+ * Field and its Jacobian of a single solenoid at a single point.
+ */
+mag_field_grad_2d_t
+solb_single_grad(const top_solenoid_t *sol, double r, double z)
+{
+	solb_coil_t coil;
+	if (!solb_compile(sol, &coil))
+	{
+		mag_field_grad_2d_t res;
+		return res;
+	}
+	return solb_eval_grad(&coil, r, z);
+}
+
+/* Overlap length w(d) of [z1, z2] and [h1 + d, h2 + d]. */
+static inline double
+axial_overlap(double z1, double z2, double h1, double h2, double d)
+{
+	double lo = z1 > h1 + d ? z1 : h1 + d;
+	double hi = z2 < h2 + d ? z2 : h2 + d;
+	return hi > lo ? hi - lo : 0;
+}
+
+/* Axial lanes of the loops of radius a and r; the panels between the
+ * breakpoints bp of w(d) are graded towards d = 0 down to |a - r|. */
+static void
+mutual_axial(const solb_coil_t *si, const solb_coil_t *sj, double a, double r,
+		double c, const double *bp, int nbp, int order, const double *xd,
+		const double *wd, lane_block_t *blk, double *M, double *dummy)
+{
+	double edge[5 + 2 * MUTUAL_MAX_LEVEL];
+	int ne = 0;
+	for (int p = 0; p < nbp; ++p)
+	{
+		double prev = p > 0 ? bp[p - 1] : bp[p];
+		double next = p + 1 < nbp ? bp[p + 1] : bp[p];
+		if (bp[p] == 0 && prev < 0)
+		{
+			for (int l = 1; l <= MUTUAL_MAX_LEVEL
+					&& -prev * pow(MUTUAL_GRADING, l - 1) > fabs(a - r); ++l)
+				edge[ne++] = prev * pow(MUTUAL_GRADING, l);
+		}
+		edge[ne++] = bp[p];
+		if (bp[p] == 0 && next > 0)
+		{
+			int nl = 0;
+			while (nl < MUTUAL_MAX_LEVEL
+					&& next * pow(MUTUAL_GRADING, nl) > fabs(a - r))
+				++nl;
+			for (int l = nl; l >= 1; --l)
+				edge[ne++] = next * pow(MUTUAL_GRADING, l);
+		}
+	}
+
+	for (int p = 0; p + 1 < ne; ++p)
+	{
+		double mid = (edge[p] + edge[p + 1]) * 0.5;
+		double hw = (edge[p + 1] - edge[p]) * 0.5;
+		if (!(hw > 0))
+			continue;
+		for (int m = 0; m < order; ++m)
+		{
+			double d = mid + hw * xd[m];
+			double w = axial_overlap(si->b1, si->b2, sj->b1, sj->b2, d);
+			lane_block_lane(blk, a, r, d, c * wd[m] * hw * w, 0, 0, M, dummy);
+		}
+	}
+}
+
+/*
+ * solb_mutual
+ * Mutual inductance per turn squared of two compiled solenoids, each of
+ * uniform current density over its cross-section. Two coaxial loops link
+ * M = mu0 * r1 * ((1 - ksq / 2) * K - E), which is mu0 * pi / 4 times the
+ * radial lane of unit weight, so the lanes of the field kernel sum
+ * M(a, r, z - h) over the radius r of si, the radius a of sj and the axial
+ * offset d = z - h, the last weighted by the overlap of both windings.
+ * M peaks logarithmically as |a - r| + |d| vanishes. The radial integral of
+ * si splits at the edges of sj and that of sj at r, and the axial panels
+ * next to d = 0 are graded geometrically down to |a - r|, which keeps thin
+ * windings accurate.
+ * Passing the same coil twice gives its self inductance.
+ */
+double
+solb_mutual(const solb_coil_t *si, const solb_coil_t *sj)
+{
+	/* Breakpoints of the axial offset; w(d) is linear in between. */
+	double bp[5] = { si->b1 - sj->b2, si->b1 - sj->b1, si->b2 - sj->b2,
+		si->b2 - sj->b1, 0 };
+	int nbp = bp[0] < 0 && bp[3] > 0 ? 5 : 4;
+	std::sort(bp, bp + nbp);
+
+	int order = std::max(si->order, sj->order);
+	const double *xr = gl_nodes(si->order);
+	const double *wr = gl_weights(si->order);
+	const double *xa = gl_nodes(sj->order);
+	const double *wa = gl_weights(sj->order);
+	const double *xd = gl_nodes(order);
+	const double *wd = gl_weights(order);
+
+	/* Radial segments of si, split at the edges of sj. */
+	double re[4] = { si->a1, sj->a1, sj->a2, si->a2 };
+	int nre = 0;
+	for (int e = 0; e < 4; ++e)
+	{
+		if (e == 0 || e == 3 || (re[e] > si->a1 && re[e] < si->a2))
+			re[nre++] = re[e];
+	}
+
+	double M = 0;
+	double dummy = 0;
+	lane_block_t blk;
+	lane_block_init(&blk, sj->kernel, sj->tier, NULL, NULL);
+	for (int t = 0; t + 1 < nre; ++t)
+	{
+		double midr = (re[t] + re[t + 1]) * 0.5;
+		double hwr = (re[t + 1] - re[t]) * 0.5;
+		for (int i = 0; i < si->order; ++i)
+		{
+			double r = midr + hwr * xr[i];
+			double cr = 1e-7 * M_PI * M_PI * wr[i] * hwr;
+
+			/* Radial segments of sj, split at r. */
+			int nseg = r > sj->a1 && r < sj->a2 ? 2 : 1;
+			double lo[2] = { sj->a1, r };
+			double hi[2] = { nseg == 2 ? r : sj->a2, sj->a2 };
+			for (int s = 0; s < nseg; ++s)
+			{
+				double mida = (lo[s] + hi[s]) * 0.5;
+				double hwa = (hi[s] - lo[s]) * 0.5;
+				for (int k = 0; k < sj->order; ++k)
+				{
+					double a = mida + hwa * xa[k];
+					double ca = cr * wa[k] * hwa;
+					mutual_axial(si, sj, a, r, ca, bp, nbp, order, xd, wd, &blk,
+							&M, &dummy);
+				}
+			}
+		}
+	}
+	if (blk.n > 0)
+		lane_block_eval(&blk, &M, &dummy);
+
+	return M / ((si->a2 - si->a1) * (si->b2 - si->b1)
+			* (sj->a2 - sj->a1) * (sj->b2 - sj->b1));
+}
+
+/* Adaptive radial quadrature.
+ * The integrand of each end face is analytic in the node radius a except at
+ * a = r, where the axial term jumps, and at a = r +- i|z - h|, where the
+ * modulus reaches 1. If the nearest one lies on the Bernstein ellipse E_rho of
+ * a panel, an N-point Gauss-Legendre rule errs by about
+ * rho ** -2N / (1 - rho ** -2) relative to the panel. Each panel takes the
+ * smallest order meeting the tolerance, and panels that would need more than
+ * QUAD_ORDER_MAX nodes are bisected. */
+typedef struct _panel_t
+{
+	double lo;
+	double hi;
+	int face;		/* 0 for b1, 1 for b2 */
+	int order;
+	double est;		/* Relative error estimate */
+} panel_t;
+
+/* Parameter rho of the Bernstein ellipse of (lo, hi) through sre + i * sim. */
+static double
+bernstein_rho(double lo, double hi, double sre, double sim)
+{
+	double hw = (hi - lo) * 0.5;
+	std::complex<double> t((sre - (lo + hi) * 0.5) / hw, sim / hw);
+	std::complex<double> s = std::sqrt(t - 1.0) * std::sqrt(t + 1.0);
+	return std::max(std::abs(t + s), std::abs(t - s));
+}
+
+/* Split a radial segment of a single end face into panels. The jump at a = r
+ * is skipped for segments ending at r, on which the integrand is one-sided. */
+static int
+adapt_segment(double lo, double hi, double r, double dz, int face,
+		int onesided, double tol, panel_t *panels)
+{
+	double stk_lo[ADAPT_MAX_DEPTH + 1];
+	double stk_hi[ADAPT_MAX_DEPTH + 1];
+	int stk_depth[ADAPT_MAX_DEPTH + 1];
+	int nstk = 0;
+	int np = 0;
+
+	stk_lo[nstk] = lo;
+	stk_hi[nstk] = hi;
+	stk_depth[nstk++] = 0;
+	while (nstk > 0)
+	{
+		--nstk;
+		double plo = stk_lo[nstk];
+		double phi = stk_hi[nstk];
+		int depth = stk_depth[nstk];
+
+		/* The jump at a = r lies inside the ellipses through r +- i|z - h|
+		 * and -r +- i|z - h|, so it is the only one that matters when
+		 * present. */
+		double rho;
+		if (onesided)
+			rho = bernstein_rho(plo, phi, r, fabs(dz));
+		else
+		{
+			double t = fabs(r - (plo + phi) * 0.5) / ((phi - plo) * 0.5);
+			rho = t > 1 ? t + sqrt(t * t - 1) : 1;
+		}
+
+		/* Smallest order with rho ** -2N / (1 - rho ** -2) <= tol. */
+		double need = QUAD_ORDER_MAX + 1;
+		if (rho > 1 + 1e-12)
+			need = -log(tol * (1 - 1 / (rho * rho))) / (2 * log(rho));
+		int order = need < QUAD_ORDER_MIN ? QUAD_ORDER_MIN : (int)ceil(need);
+
+		/* Leaves are stacked in order, so room is left for every pending
+		 * panel before bisecting. */
+		if (order > QUAD_ORDER_MAX && depth < ADAPT_MAX_DEPTH
+				&& np + nstk + 2 <= ADAPT_MAX_PANELS)
+		{
+			double pmid = (plo + phi) * 0.5;
+			stk_lo[nstk] = pmid;
+			stk_hi[nstk] = phi;
+			stk_depth[nstk++] = depth + 1;
+			stk_lo[nstk] = plo;
+			stk_hi[nstk] = pmid;
+			stk_depth[nstk++] = depth + 1;
+			continue;
+		}
+
+		if (order > QUAD_ORDER_MAX)
+			order = QUAD_ORDER_MAX;
+		panels[np].lo = plo;
+		panels[np].hi = phi;
+		panels[np].face = face;
+		panels[np].order = order;
+		panels[np].est = rho > 1 + 1e-12
+			? pow(rho, -2.0 * order) / (1 - 1 / (rho * rho)) : 1;
+		++np;
+	}
+	return np;
+}
+
+void
+solb_eval_adaptive_batch(const solb_coil_t *coil, const double *r,
+		const double *z, size_t n, double tol, double *Br, double *Bz,
+		double *err)
+{
+	/* Every probe owns a slot per panel, so that the error estimate can be
+	 * weighed by the size of the panel's contribution. */
+	const int slots = 2 * 2 * ADAPT_MAX_PANELS;
+	panel_t panels[ADAPT_GROUP * slots];
+	double sBr[ADAPT_GROUP * slots];
+	double sBz[ADAPT_GROUP * slots];
+	int np[ADAPT_GROUP];
+
+	/* The panels meet the tolerance; the kernels converge as in the full
+	 * tier whatever the tier of the coil. */
+	lane_block_t blk;
+	lane_block_init(&blk, coil->kernel, SOLB_TIER_FULL, NULL, NULL);
+	for (size_t g = 0; g < n; g += ADAPT_GROUP)
+	{
+		size_t ng = std::min((size_t)ADAPT_GROUP, n - g);
+		for (size_t k = 0; k < ng; ++k)
+		{
+			double rk = r[g + k];
+			double zk = z[g + k];
+			double a1 = coil->a1;
+			double a2 = coil->a2;
+			double dz[2] = { zk - coil->b1, zk - coil->b2 };
+			double rinv = (rk / a1 < NEAR_CENTER_THRESHOLD) ? 0 : 0.5 / rk;
+			panel_t *pk = panels + k * slots;
+
+			/* Panels of every radial segment and end face. */
+			int cnt = 0;
+			for (int f = 0; f < 2; ++f)
+			{
+				if (rk > a1 && rk < a2)
+				{
+					cnt += adapt_segment(a1, rk, rk, dz[f], f, 1, tol, pk + cnt);
+					cnt += adapt_segment(rk, a2, rk, dz[f], f, 1, tol, pk + cnt);
+				}
+				else
+					cnt += adapt_segment(a1, a2, rk, dz[f], f, 0, tol, pk + cnt);
+			}
+			np[k] = cnt;
+			stats_count(STATS_PANELS, cnt);
+
+			for (int p = 0; p < cnt; ++p)
+			{
+				size_t slot = k * slots + p;
+				sBr[slot] = 0;
+				sBz[slot] = 0;
+
+				const double *xq = gl_nodes(pk[p].order);
+				const double *wq = gl_weights(pk[p].order);
+				double mid = (pk[p].lo + pk[p].hi) * 0.5;
+				double hw = (pk[p].hi - pk[p].lo) * 0.5;
+				double c = coil->c * (pk[p].hi - pk[p].lo);
+				double sgn = pk[p].face ? 1 : -1;
+				for (int i = 0; i < pk[p].order; ++i)
+				{
+					double wc = wq[i] * c;
+					lane_block_lane(&blk, mid + hw * xq[i], rk, dz[pk[p].face],
+							sgn * wc * rinv, -sgn * wc, slot, sBr, sBz);
+				}
+			}
+		}
+		if (blk.n > 0)
+			lane_block_eval(&blk, sBr, sBz);
+
+		for (size_t k = 0; k < ng; ++k)
+		{
+			double Brk = 0;
+			double Bzk = 0;
+			double errk = 0;
+			for (int p = 0; p < np[k]; ++p)
+			{
+				size_t slot = k * slots + p;
+				Brk += sBr[slot];
+				Bzk += sBz[slot];
+				errk += panels[slot].est * (fabs(sBr[slot]) + fabs(sBz[slot]));
+			}
+			Br[g + k] = Brk;
+			Bz[g + k] = Bzk;
+			if (err != NULL)
+				err[g + k] = errk;
+		}
+	}
+}
+
+mag_field_2d_t
+solb_eval_adaptive(const solb_coil_t *coil, double r, double z, double tol,
+		double *err)
+{
+	double Br;
+	double Bz;
+	solb_eval_adaptive_batch(coil, &r, &z, 1, tol, &Br, &Bz, err);
+
+	mag_field_2d_t B{Br, Bz};
+
+	return B;
+}
@@ -1,40 +1,104 @@
-/**
- * solb.h
- *
- * Version 1.0 @ 08/14/2018
- *
- * Jaerin Lee
- * Applied Superconductivity Laboratory
- * Dept. of Electrical and Computer Engineering
- * Seoul National University
- */
-
-#ifndef __SOLB_H__
-#define __SOLB_H__
-
-#define DEBUG
-
-#include <stddef.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
-
-/* For test codes. */
-#ifdef DEBUG
-	#include <time.h>
-#endif
-
-#include "mkl.h"
-
-#include "physics.h"
-#include "topology.h"
-#include "gauss-quad.h"
-
-/* External dependencies. */
-extern const double x[];
-extern const double w[];
-
-/* Public interfaces. */
-mag_field_2d_t solb_single(const top_solenoid_t *sol, double r, double z);
-
-#endif
+/**
+ * solb.h
+ *
+ * Version 1.0 @ 08/14/2018
+ *
+ * Jaerin Lee
+ * Applied Superconductivity Laboratory
+ * Dept. of Electrical and Computer Engineering
+ * Seoul National University
+ */
+
+#ifndef __SOLB_H__
+#define __SOLB_H__
+
+#define DEBUG
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* For test codes. */
+#ifdef DEBUG
+	#include <time.h>
+#endif
+
+#include "vmath.h"
+
+#include "physics.h"
+#include "topology.h"
+#include "gauss-quad.h"
+
+/* Elliptic integral kernels of the compiled evaluation. */
+#define SOLB_KERNEL_AGM 0		// Garrett's AGM iteration, masked per lane
+#define SOLB_KERNEL_CARLSON 1	// Closed form by Carlson's integrals; branchless
+
+/* Accuracy tiers of the fixed-order evaluation. Relaxed tiers stop the
+ * elliptic integrals earlier and take, segment by segment, the order their
+ * error estimate calls for, up to the compiled order; they meet the relative
+ * error of the field below wherever the compiled order does. The fine tier
+ * grades its nodes near the windings and raises the order there instead. */
+#define SOLB_TIER_FULL 0		// Default; AGM to ERROR_REF at the compiled order
+#define SOLB_TIER_PPB 1		// 1e-9
+#define SOLB_TIER_PPM 2		// 1e-6
+#define SOLB_TIER_SINGLE 3		// 1e-5 where coils cancel < 100-fold; AGM in float
+#define SOLB_TIER_FINE 4		// Full, refined near the windings
+#define SOLB_NTIER 5
+
+/* Solenoid compiled for repeated evaluation; holds the validated dimensions
+ * and the quadrature state of the radial integral. */
+typedef struct _solb_coil_t
+{
+	double a1;
+	double a2;
+	double b1;
+	double b2;
+	double j;
+	double c;				/* 0.5e-7 * j * pi */
+	int order;				/* Order of the Gauss-Legendre rule */
+	int kernel;				/* SOLB_KERNEL_* */
+	int tier;				/* SOLB_TIER_* */
+	double a[QUAD_ORDER_MAX];	/* Quadrature nodes over (a1, a2) */
+	double w[QUAD_ORDER_MAX];	/* Weights scaled by 0.5e-7 * j * (a2 - a1) * pi */
+} solb_coil_t;
+
+/* External dependencies. */
+extern const double x[];
+extern const double w[];
+
+/* Public interfaces. */
+mag_field_2d_t solb_single(const top_solenoid_t *sol, double r, double z);
+int solb_compile(const top_solenoid_t *sol, solb_coil_t *coil,
+		int order = QUAD_ORDER);
+int solb_set_kernel(solb_coil_t *coil, int kernel);
+int solb_set_tier(solb_coil_t *coil, int tier);
+int solb_tier_parse(const char *name);
+const char *solb_tier_name(int tier);
+mag_field_2d_t solb_eval(const solb_coil_t *coil, double r, double z);
+void solb_eval_batch(const solb_coil_t *coil, const double *r, const double *z,
+		size_t n, double *Br, double *Bz);
+void solb_eval_column(const solb_coil_t *coil, double r, const double *z,
+		size_t n, double *Br, double *Bz);
+
+/* Adaptive radial quadrature meeting a relative tolerance; err, if not NULL,
+ * receives the estimated absolute error of |Br| + |Bz|. */
+mag_field_2d_t solb_eval_adaptive(const solb_coil_t *coil, double r, double z,
+		double tol, double *err);
+void solb_eval_adaptive_batch(const solb_coil_t *coil, const double *r,
+		const double *z, size_t n, double tol, double *Br, double *Bz,
+		double *err);
+int solb_batch(const top_solenoid_t *sol, const double *r, const double *z,
+		size_t n, double *Br, double *Bz);
+
+/* Field with its Jacobian at about the cost of the field alone. */
+mag_field_grad_2d_t solb_single_grad(const top_solenoid_t *sol, double r,
+		double z);
+mag_field_grad_2d_t solb_eval_grad(const solb_coil_t *coil, double r, double z);
+void solb_eval_grad_batch(const solb_coil_t *coil, const double *r,
+		const double *z, size_t n, mag_field_grad_2d_t *res);
+
+/* Mutual inductance per turn squared, H; self inductance if si == sj. */
+double solb_mutual(const solb_coil_t *si, const solb_coil_t *sj);
+
+#endif
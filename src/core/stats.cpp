@@ -0,0 +1,260 @@
+/**
+ * stats.cpp
+ *
+ * Run statistics, kept per thread and merged at the end of the run. A thread
+ * registers its storage on its first hook and never releases it, so that the
+ * counts of threads gone before the merge, such as a writer, still add up.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "stats.h"
+
+int stats_enabled = 0;
+
+/* Storage of a single thread, and its hardware counters; a group led by
+ * fd[0], of which members that could not be opened hold -1. */
+typedef struct _stats_slot_t
+{
+	stats_t st;
+	int fd[STATS_NHW];
+} stats_slot_t;
+
+static const char *count_names[STATS_NCOUNT] = {
+	"probes", "probes_inside", "probes_relaxed", "blocks", "lanes", "lanes_pad",
+	"panels", "single", "single_inside"
+};
+static const char *time_names[STATS_NTIME] = {
+	"parse", "compile", "eval", "kernel", "face_b1", "face_b2", "inside", "format",
+	"write"
+};
+static const char *hw_names[STATS_NHW] = {
+	"cycles", "instructions", "cache_misses", "branch_misses"
+};
+static const unsigned long long hw_config[STATS_NHW] = {
+	PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static std::mutex stats_mtx;
+static std::vector<stats_slot_t *> stats_slots;
+static unsigned long long stats_start;
+static thread_local stats_slot_t *stats_mine = NULL;
+
+/* Counter of the calling thread in user space, in the group of leader. */
+static int
+stats_perf_open(unsigned long long config, int leader)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.read_format = PERF_FORMAT_GROUP;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+static stats_slot_t *
+stats_register()
+{
+	stats_slot_t *slot = new stats_slot_t();
+	slot->fd[0] = stats_perf_open(hw_config[0], -1);
+	for (int k = 1; k < STATS_NHW; ++k)
+		slot->fd[k] = slot->fd[0] >= 0 ? stats_perf_open(hw_config[k], slot->fd[0]) : -1;
+
+	std::lock_guard<std::mutex> lock(stats_mtx);
+	stats_slots.push_back(slot);
+	return slot;
+}
+
+/*
+ * stats_enable
+ * Start counting, and the wall clock of the run, on every thread.
+ */
+void
+stats_enable()
+{
+	stats_enabled = 1;
+	stats_start = stats_now();
+	stats_local();
+}
+
+stats_t *
+stats_local()
+{
+	if (stats_mine == NULL)
+		stats_mine = stats_register();
+	return &stats_mine->st;
+}
+
+/*
+ * stats_merge
+ * Sum the storage of every thread into total. Threads may still be counting;
+ * the merge is meant for the end of the run.
+ */
+void
+stats_merge(stats_t *total)
+{
+	memset(total, 0, sizeof(*total));
+	total->wall = (stats_now() - stats_start) * 1e-9;
+
+	std::lock_guard<std::mutex> lock(stats_mtx);
+	for (size_t t = 0; t < stats_slots.size(); ++t)
+	{
+		const stats_slot_t *slot = stats_slots[t];
+		for (int k = 0; k < STATS_NCOUNT; ++k)
+			total->count[k] += slot->st.count[k];
+		for (int k = 0; k < STATS_NTIME; ++k)
+			total->time[k] += slot->st.time[k];
+		for (int k = 0; k < STATS_AGM_BINS; ++k)
+			total->agm[k] += slot->st.agm[k];
+		for (int k = 0; k <= QUAD_ORDER_MAX; ++k)
+			total->order[k] += slot->st.order[k];
+		++total->threads;
+
+		/* A group reads as the number of its members and their values, in
+		 * the order they were opened. */
+		unsigned long long buf[STATS_NHW + 1];
+		if (slot->fd[0] < 0 || read(slot->fd[0], buf, sizeof(buf)) < (ssize_t)(2 * sizeof(buf[0])))
+			continue;
+		for (int k = 0, m = 1; k < STATS_NHW && m <= (int)buf[0]; ++k)
+		{
+			if (slot->fd[k] >= 0)
+				total->hw[k] += buf[m++];
+		}
+		++total->hw_threads;
+	}
+}
+
+/* Mean AGM iterations of a lane; the last bin counts at its lower end. */
+static double
+stats_agm_mean(const stats_t *st, unsigned long long *lanes)
+{
+	double sum = 0;
+	*lanes = 0;
+	for (int k = 0; k < STATS_AGM_BINS; ++k)
+	{
+		sum += (double)k * st->agm[k];
+		*lanes += st->agm[k];
+	}
+	return *lanes > 0 ? sum / *lanes : 0;
+}
+
+/*
+ * stats_print
+ * Print the merged statistics as a report.
+ */
+void
+stats_print(FILE *fp, const stats_t *st)
+{
+	fprintf(fp, " Wall time %.3lf s over %d threads\n\n", st->wall, st->threads);
+
+	fprintf(fp, " Timer           Thread time[s]\n");
+	fprintf(fp, " ---------------------------------------------------------\n");
+	for (int k = 0; k < STATS_NTIME; ++k)
+	{
+		if (st->time[k] > 0)
+			fprintf(fp, " %-16s%14.6lf\n", time_names[k], st->time[k] * 1e-9);
+	}
+
+	fprintf(fp, "\n Counter                  Count\n");
+	fprintf(fp, " ---------------------------------------------------------\n");
+	for (int k = 0; k < STATS_NCOUNT; ++k)
+	{
+		if (st->count[k] > 0)
+			fprintf(fp, " %-16s%14llu\n", count_names[k], st->count[k]);
+	}
+
+	unsigned long long lanes;
+	double mean = stats_agm_mean(st, &lanes);
+	if (lanes > 0)
+	{
+		fprintf(fp, "\n AGM iterations per lane, mean %.3lf\n", mean);
+		fprintf(fp, " ---------------------------------------------------------\n");
+		for (int k = 0; k < STATS_AGM_BINS; ++k)
+		{
+			if (st->agm[k] > 0)
+				fprintf(fp, " %3d%s%14llu%10.4lf%%\n", k, k == STATS_AGM_BINS - 1 ? "+" : " ",
+						st->agm[k], 100.0 * st->agm[k] / lanes);
+		}
+	}
+
+	int orders = 0;
+	for (int k = 0; k <= QUAD_ORDER_MAX; ++k)
+		orders += st->order[k] > 0;
+	if (orders > 1)
+	{
+		fprintf(fp, "\n Quadrature order per probe\n");
+		fprintf(fp, " ---------------------------------------------------------\n");
+		for (int k = 0; k <= QUAD_ORDER_MAX; ++k)
+		{
+			if (st->order[k] > 0)
+				fprintf(fp, " %3d %14llu%10.4lf%%\n", k, st->order[k],
+						100.0 * st->order[k] / st->count[STATS_PROBES]);
+		}
+	}
+
+	fprintf(fp, "\n Hardware counter         Count\n");
+	fprintf(fp, " ---------------------------------------------------------\n");
+	if (st->hw_threads == 0)
+		fprintf(fp, " Unavailable; see perf_event_paranoid\n");
+	else
+	{
+		for (int k = 0; k < STATS_NHW; ++k)
+			fprintf(fp, " %-16s%14llu\n", hw_names[k], st->hw[k]);
+		if (st->hw[STATS_HW_CYCLES] > 0)
+			fprintf(fp, " IPC %.3lf over %d of %d threads\n",
+					(double)st->hw[STATS_HW_INSTRUCTIONS] / st->hw[STATS_HW_CYCLES],
+					st->hw_threads, st->threads);
+	}
+}
+
+/*
+ * stats_write_json
+ * Write the merged statistics as a JSON object; hardware counters are null
+ * where unavailable.
+ */
+void
+stats_write_json(FILE *fp, const stats_t *st)
+{
+	fprintf(fp, "{\n  \"wall\": %.9lf,\n  \"threads\": %d,\n  \"time\": {", st->wall,
+			st->threads);
+	for (int k = 0; k < STATS_NTIME; ++k)
+		fprintf(fp, "%s\n    \"%s\": %.9lf", k ? "," : "", time_names[k], st->time[k] * 1e-9);
+	fprintf(fp, "\n  },\n  \"count\": {");
+	for (int k = 0; k < STATS_NCOUNT; ++k)
+		fprintf(fp, "%s\n    \"%s\": %llu", k ? "," : "", count_names[k], st->count[k]);
+
+	/* Bins are indexed by iterations, the last holding the rest. */
+	fprintf(fp, "\n  },\n  \"agm_iterations\": [");
+	for (int k = 0; k < STATS_AGM_BINS; ++k)
+		fprintf(fp, "%s%llu", k ? ", " : "", st->agm[k]);
+	fprintf(fp, "],\n  \"order\": {");
+	int first = 1;
+	for (int k = 0; k <= QUAD_ORDER_MAX; ++k)
+	{
+		if (st->order[k] > 0)
+		{
+			fprintf(fp, "%s\"%d\": %llu", first ? "" : ", ", k, st->order[k]);
+			first = 0;
+		}
+	}
+	fprintf(fp, "},\n  \"hw_threads\": %d,\n  \"hw\": {", st->hw_threads);
+	for (int k = 0; k < STATS_NHW; ++k)
+	{
+		if (st->hw_threads > 0)
+			fprintf(fp, "%s\n    \"%s\": %llu", k ? "," : "", hw_names[k], st->hw[k]);
+		else
+			fprintf(fp, "%s\n    \"%s\": null", k ? "," : "", hw_names[k]);
+	}
+	fprintf(fp, "\n  }\n}\n");
+}
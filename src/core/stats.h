@@ -0,0 +1,107 @@
+/**
+ * stats.h
+ *
+ * Run statistics. Counters, timers and the histogram of AGM iterations are
+ * kept by every thread in storage of its own and merged once, at the end of
+ * the run, so the hot path never contends for a cache line. Nothing is
+ * counted until stats_enable(); until then the hooks cost a single branch.
+ * Hardware counters are read through perf_event_open(2) where the kernel
+ * allows it.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdio.h>
+#include <time.h>
+
+#include "gauss-quad.h"
+
+/* Event counters. */
+#define STATS_PROBES 0			// Probes pushed to the batch kernel, per coil
+#define STATS_PROBES_INSIDE 1	// Of those, inside the winding; split at r
+#define STATS_PROBES_RELAXED 2	// Of those, taking another order than the compiled one
+#define STATS_BLOCKS 3			// Lane blocks run
+#define STATS_LANES 4			// Lanes of those blocks
+#define STATS_LANES_PAD 5		// Idle lanes padding them
+#define STATS_PANELS 6			// Panels of the adaptive quadrature
+#define STATS_SINGLE 7			// Evaluations of solb_single()
+#define STATS_SINGLE_INSIDE 8	// Of those, inside the winding
+#define STATS_NCOUNT 9
+
+/* Timers, in nanoseconds summed over threads. */
+#define STATS_T_PARSE 0			// Parsing coils and probes
+#define STATS_T_COMPILE 1		// Compiling coils and expansions
+#define STATS_T_EVAL 2			// Evaluation of the field
+#define STATS_T_KERNEL 3		// Of which, the lane kernels
+#define STATS_T_FACE1 4			// Pass of the b1 face of solb_internal()
+#define STATS_T_FACE2 5			// Pass of the b2 face of solb_internal()
+#define STATS_T_INSIDE 6		// solb_single() inside the winding
+#define STATS_T_FORMAT 7		// Formatting of the text output
+#define STATS_T_WRITE 8			// Writing the output
+#define STATS_NTIME 9
+
+/* Hardware counters. */
+#define STATS_HW_CYCLES 0
+#define STATS_HW_INSTRUCTIONS 1
+#define STATS_HW_CACHE_MISSES 2
+#define STATS_HW_BRANCH_MISSES 3
+#define STATS_NHW 4
+
+#define STATS_AGM_BINS 32		// Iterations of the AGM; the last bin takes the rest
+
+typedef struct _stats_t
+{
+	unsigned long long count[STATS_NCOUNT];
+	unsigned long long time[STATS_NTIME];
+	unsigned long long agm[STATS_AGM_BINS];	/* Lanes by AGM iterations */
+	unsigned long long order[QUAD_ORDER_MAX + 1];	/* Probes by order taken */
+	unsigned long long hw[STATS_NHW];
+	int threads;			/* Threads merged */
+	int hw_threads;			/* Of which, with hardware counters */
+	double wall;			/* Seconds since stats_enable() */
+} stats_t;
+
+extern int stats_enabled;
+
+/* Public interfaces. */
+void stats_enable();
+stats_t *stats_local();
+void stats_merge(stats_t *total);
+void stats_print(FILE *fp, const stats_t *st);
+void stats_write_json(FILE *fp, const stats_t *st);
+
+/* Hooks of the hot path; no-ops until stats_enable(). */
+static inline unsigned long long
+stats_now()
+{
+	if (!stats_enabled)
+		return 0;
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline void
+stats_time(int k, unsigned long long t0)
+{
+	if (stats_enabled)
+		stats_local()->time[k] += stats_now() - t0;
+}
+
+static inline void
+stats_count(int k, unsigned long long n)
+{
+	if (stats_enabled)
+		stats_local()->count[k] += n;
+}
+
+static inline int
+stats_agm_bin(int iter)
+{
+	return iter < STATS_AGM_BINS - 1 ? iter : STATS_AGM_BINS - 1;
+}
+
+#endif
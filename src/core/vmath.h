@@ -0,0 +1,153 @@
+/**
+ * vmath.h
+ *
+ * Vector arithmetic backend of the core. The core works on arrays of only
+ * QUAD_ORDER elements, where call dispatch of a vendor library costs more
+ * than the math itself; the portable backend inlines the same operations as
+ * plain loops. Define SOLB_MKL to forward to Intel MKL VML/BLAS instead.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __VMATH_H__
+#define __VMATH_H__
+
+#include <math.h>
+
+#ifdef SOLB_MKL
+
+#include "mkl.h"
+
+#define VM_BACKEND "mkl"
+
+static inline void
+vm_sqr(int n, const double *a, double *y) { vdSqr(n, a, y); }
+
+static inline void
+vm_sqrt(int n, const double *a, double *y) { vdSqrt(n, a, y); }
+
+static inline void
+vm_add(int n, const double *a, const double *b, double *y) { vdAdd(n, a, b, y); }
+
+static inline void
+vm_mul(int n, const double *a, const double *b, double *y) { vdMul(n, a, b, y); }
+
+static inline void
+vm_div(int n, const double *a, const double *b, double *y) { vdDiv(n, a, b, y); }
+
+static inline void
+vm_linear_frac(int n, const double *a, const double *b,
+		double scalea, double shifta, double scaleb, double shiftb, double *y)
+{
+	vdLinearFrac(n, a, b, scalea, shifta, scaleb, shiftb, y);
+}
+
+static inline void
+vm_copy(int n, const double *x, int incx, double *y, int incy)
+{
+	cblas_dcopy(n, x, incx, y, incy);
+}
+
+static inline void
+vm_axpy(int n, double a, const double *x, int incx, double *y, int incy)
+{
+	cblas_daxpy(n, a, x, incx, y, incy);
+}
+
+static inline void
+vm_axpby(int n, double a, const double *x, int incx, double b, double *y, int incy)
+{
+	cblas_daxpby(n, a, x, incx, b, y, incy);
+}
+
+static inline double
+vm_dot(int n, const double *x, int incx, const double *y, int incy)
+{
+	return cblas_ddot(n, x, incx, y, incy);
+}
+
+#else
+
+#define VM_BACKEND "portable"
+
+/* Same semantics as the VML/BLAS routines of the same name; strides of the
+ * BLAS-like routines may be 0 to broadcast a scalar. */
+static inline void
+vm_sqr(int n, const double *a, double *y)
+{
+	for (int i = 0; i < n; ++i)
+		y[i] = a[i] * a[i];
+}
+
+static inline void
+vm_sqrt(int n, const double *a, double *y)
+{
+	for (int i = 0; i < n; ++i)
+		y[i] = sqrt(a[i]);
+}
+
+static inline void
+vm_add(int n, const double *a, const double *b, double *y)
+{
+	for (int i = 0; i < n; ++i)
+		y[i] = a[i] + b[i];
+}
+
+static inline void
+vm_mul(int n, const double *a, const double *b, double *y)
+{
+	for (int i = 0; i < n; ++i)
+		y[i] = a[i] * b[i];
+}
+
+static inline void
+vm_div(int n, const double *a, const double *b, double *y)
+{
+	for (int i = 0; i < n; ++i)
+		y[i] = a[i] / b[i];
+}
+
+/* y = (scalea * a + shifta) / (scaleb * b + shiftb) */
+static inline void
+vm_linear_frac(int n, const double *a, const double *b,
+		double scalea, double shifta, double scaleb, double shiftb, double *y)
+{
+	for (int i = 0; i < n; ++i)
+		y[i] = (scalea * a[i] + shifta) / (scaleb * b[i] + shiftb);
+}
+
+static inline void
+vm_copy(int n, const double *x, int incx, double *y, int incy)
+{
+	for (int i = 0; i < n; ++i)
+		y[i * incy] = x[i * incx];
+}
+
+/* y = a * x + y */
+static inline void
+vm_axpy(int n, double a, const double *x, int incx, double *y, int incy)
+{
+	for (int i = 0; i < n; ++i)
+		y[i * incy] += a * x[i * incx];
+}
+
+/* y = a * x + b * y */
+static inline void
+vm_axpby(int n, double a, const double *x, int incx, double b, double *y, int incy)
+{
+	for (int i = 0; i < n; ++i)
+		y[i * incy] = a * x[i * incx] + b * y[i * incy];
+}
+
+static inline double
+vm_dot(int n, const double *x, int incx, const double *y, int incy)
+{
+	double s = 0;
+	for (int i = 0; i < n; ++i)
+		s += x[i * incx] * y[i * incy];
+	return s;
+}
+
+#endif
+
+#endif
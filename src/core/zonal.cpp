@@ -0,0 +1,325 @@
+/**
+ * zonal.cpp
+ *
+ * Zonal harmonic expansion of the field of a coil set. The on-axis field of
+ * a solenoid is known in closed form,
+ * Bz(0, z) = mu0 * j / 2 * (F(z - b1) - F(z - b2)),
+ * F(u) = u * log((a2 + sqrt(a2 ** 2 + u ** 2)) / (a1 + sqrt(a1 ** 2 + u ** 2))),
+ * and its Taylor coefficients are taken exactly by evaluating F in truncated
+ * power series arithmetic. Off the axis, with rho ** 2 = r ** 2 + t ** 2,
+ * Bz = SIGMA_n b[n] * rho ** n * P_n(t / rho)
+ * Br = -SIGMA_n b[n] / (n + 1) * rho ** n * P_n^1(t / rho)
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <vector>
+
+#include "zonal.h"
+
+#define MU0 (4e-7 * M_PI)
+#define ZH_RMAX_ITER 60 // Bisections of the radius meeting the tolerance
+
+/* Truncated power series arithmetic over n + 1 coefficients. */
+static void
+ts_mul(int n, const double *a, const double *b, double *c)
+{
+	for (int k = n; k >= 0; --k)
+	{
+		double s = 0;
+		for (int i = 0; i <= k; ++i)
+			s += a[i] * b[k - i];
+		c[k] = s;
+	}
+}
+
+static void
+ts_sqrt(int n, const double *a, double *c)
+{
+	c[0] = sqrt(a[0]);
+	for (int k = 1; k <= n; ++k)
+	{
+		double s = a[k];
+		for (int i = 1; i < k; ++i)
+			s -= c[i] * c[k - i];
+		c[k] = s / (2 * c[0]);
+	}
+}
+
+static void
+ts_log(int n, const double *a, double *c)
+{
+	c[0] = log(a[0]);
+	for (int k = 1; k <= n; ++k)
+	{
+		double s = k * a[k];
+		for (int i = 1; i < k; ++i)
+			s -= i * c[i] * a[k - i];
+		c[k] = s / (k * a[0]);
+	}
+}
+
+/* Series of log(a + sqrt(a ** 2 + (u0 + t) ** 2)) in t. */
+static void
+ts_face_log(int n, double a, double u0, double *c)
+{
+	double s[ZH_ORDER_MAX + 1];
+	double q[ZH_ORDER_MAX + 1];
+	for (int k = 0; k <= n; ++k)
+		q[k] = 0;
+	q[0] = a * a + u0 * u0;
+	if (n >= 1)
+		q[1] = 2 * u0;
+	if (n >= 2)
+		q[2] = 1;
+	ts_sqrt(n, q, s);
+	s[0] += a;
+	ts_log(n, s, c);
+}
+
+/* Accumulate sgn * mu0 * j / 2 * F(u0 + t) of a single end face. */
+static void
+ts_face(int n, const solb_coil_t *coil, double u0, double sgn, double *b)
+{
+	double l1[ZH_ORDER_MAX + 1];
+	double l2[ZH_ORDER_MAX + 1];
+	double u[ZH_ORDER_MAX + 1];
+	double f[ZH_ORDER_MAX + 1];
+	ts_face_log(n, coil->a2, u0, l2);
+	ts_face_log(n, coil->a1, u0, l1);
+	for (int k = 0; k <= n; ++k)
+	{
+		l2[k] -= l1[k];
+		u[k] = 0;
+	}
+	u[0] = u0;
+	if (n >= 1)
+		u[1] = 1;
+	ts_mul(n, u, l2, f);
+
+	double c = sgn * 0.5 * MU0 * coil->j;
+	for (int k = 0; k <= n; ++k)
+		b[k] += c * f[k];
+}
+
+/*
+ * zh_error
+ * Estimated truncation error of the expansion at distance rho from its
+ * center. The dropped terms are taken to decay by rho / rc per order from
+ * the last two kept, so that expansions of odd or even parity alike are
+ * covered; P_n^1 peaks near sqrt(n), hence the factor for the radial
+ * component.
+ */
+double
+zh_error(const zh_expansion_t *zh, double rho)
+{
+	int n = zh->order;
+	double q = rho / zh->rc;
+	if (q >= 1)
+		return HUGE_VAL;
+
+	double last = fabs(zh->b[n]) * pow(rho, n);
+	if (n >= 1)
+		last += fabs(zh->b[n - 1]) * pow(rho, n - 1);
+	return (1 + sqrt(n + 1.0)) * last * q / (1 - q);
+}
+
+/*
+ * zh_build
+ * Expand the field of compiled coils about (0, z0) up to the given order and
+ * find the radius within which the estimated truncation error stays below
+ * tol relative to the field scale of the expansion. Coils are kept by
+ * reference for the direct evaluation outside that radius.
+ * returns 1 on success, 0 on failure
+ */
+int
+zh_build(const solb_coil_t *coils, size_t ncoil, double z0, int order,
+		double tol, zh_expansion_t *zh)
+{
+	static const char *label = "zh_build";
+
+	/* Handle bad inputs. */
+	if (coils == NULL || ncoil == 0)
+	{
+		fprintf(stderr, "%s: No solenoid has been specified.", label);
+		return 0;
+	}
+	if (order < 1 || order > ZH_ORDER_MAX)
+	{
+		fprintf(stderr, "%s: Expansion order should be in [1, %d].", label,
+				ZH_ORDER_MAX);
+		return 0;
+	}
+	if (!(tol > 0))
+	{
+		fprintf(stderr, "%s: Tolerance should be positive.", label);
+		return 0;
+	}
+
+	/* The sphere of convergence reaches up to the nearest winding. */
+	double rc = HUGE_VAL;
+	for (size_t j = 0; j < ncoil; ++j)
+	{
+		double dz = 0;
+		if (z0 < coils[j].b1)
+			dz = coils[j].b1 - z0;
+		else if (z0 > coils[j].b2)
+			dz = z0 - coils[j].b2;
+		double d = sqrt(coils[j].a1 * coils[j].a1 + dz * dz);
+		rc = d < rc ? d : rc;
+	}
+	if (!(rc > 0))
+	{
+		fprintf(stderr, "%s: Center of the expansion lies on a winding.", label);
+		return 0;
+	}
+
+	zh->z0 = z0;
+	zh->rc = rc;
+	zh->order = order;
+	zh->coils = coils;
+	zh->ncoil = ncoil;
+	for (int k = 0; k <= ZH_ORDER_MAX; ++k)
+	{
+		zh->b[k] = 0;
+		zh->c1[k] = (2.0 * k + 1) / (k + 1);
+		zh->c2[k] = (double)k / (k + 1);
+	}
+	for (size_t j = 0; j < ncoil; ++j)
+	{
+		ts_face(order, &coils[j], z0 - coils[j].b1, 1, zh->b);
+		ts_face(order, &coils[j], z0 - coils[j].b2, -1, zh->b);
+	}
+
+	for (int k = 0; k <= ZH_ORDER_MAX; ++k)
+		zh->br[k] = zh->b[k] / (k + 1);
+
+	/* Field scale over the inner half of the sphere. */
+	zh->scale = 0;
+	for (int k = 0; k <= order; ++k)
+		zh->scale += fabs(zh->b[k]) * pow(0.5 * rc, k);
+
+	/* The estimate grows with rho; bisect for the radius meeting tol. */
+	double lo = 0;
+	double hi = rc;
+	for (int i = 0; i < ZH_RMAX_ITER; ++i)
+	{
+		double mid = (lo + hi) * 0.5;
+		if (zh_error(zh, mid) <= tol * zh->scale)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	zh->rmax = lo;
+	return 1;
+}
+
+int
+zh_inside(const zh_expansion_t *zh, double r, double z)
+{
+	double t = z - zh->z0;
+	return r * r + t * t < zh->rmax * zh->rmax;
+}
+
+/* Solid harmonics Z_n = rho ** n * P_n and Q_n = rho ** (n - 1) * P_n' follow
+ * Z_n+1 = ((2n + 1) * t * Z_n - n * rho ** 2 * Z_n-1) / (n + 1)
+ * Q_n+1 = rho ** 2 * Q_n-1 + (2n + 1) * Z_n
+ * without dividing by rho, and rho ** n * P_n^1 = r * Q_n. */
+static inline mag_field_2d_t
+zh_series(const zh_expansion_t *zh, double r, double z)
+{
+	double t = z - zh->z0;
+	double rhosq = r * r + t * t;
+	double zp = 1;
+	double zn = t;
+	double qp = 0;
+	double qn = 1;
+	double Bz = zh->b[0] + zh->b[1] * t;
+	double Br = zh->br[1];
+	for (int n = 1; n < zh->order; ++n)
+	{
+		double znext = zh->c1[n] * t * zn - zh->c2[n] * rhosq * zp;
+		double qnext = rhosq * qp + (2 * n + 1) * zn;
+		zp = zn;
+		zn = znext;
+		qp = qn;
+		qn = qnext;
+		Bz += zh->b[n + 1] * zn;
+		Br += zh->br[n + 1] * qn;
+	}
+
+	mag_field_2d_t B{-r * Br, Bz};
+
+	return B;
+}
+
+mag_field_2d_t
+zh_eval(const zh_expansion_t *zh, double r, double z)
+{
+	if (zh_inside(zh, r, z))
+		return zh_series(zh, r, z);
+
+	double Br = 0;
+	double Bz = 0;
+	for (size_t j = 0; j < zh->ncoil; ++j)
+	{
+		mag_field_2d_t res = solb_eval(&zh->coils[j], r, z);
+		Br += res.Br;
+		Bz += res.Bz;
+	}
+
+	mag_field_2d_t B{Br, Bz};
+
+	return B;
+}
+
+void
+zh_eval_batch(const zh_expansion_t *zh, const double *r, const double *z,
+		size_t n, double *Br, double *Bz)
+{
+	/* Probes outside rmax are gathered for the batch kernel of every coil. */
+	std::vector<size_t> idx;
+	for (size_t i = 0; i < n; ++i)
+	{
+		if (zh_inside(zh, r[i], z[i]))
+		{
+			mag_field_2d_t res = zh_series(zh, r[i], z[i]);
+			Br[i] = res.Br;
+			Bz[i] = res.Bz;
+		}
+		else
+			idx.push_back(i);
+	}
+	if (idx.empty())
+		return;
+
+	size_t m = idx.size();
+	std::vector<double> buf(6 * m);
+	double *ro = &buf[0];
+	double *zo = ro + m;
+	double *Bro = zo + m;
+	double *Bzo = Bro + m;
+	double *Brj = Bzo + m;
+	double *Bzj = Brj + m;
+	for (size_t i = 0; i < m; ++i)
+	{
+		ro[i] = r[idx[i]];
+		zo[i] = z[idx[i]];
+		Bro[i] = 0;
+		Bzo[i] = 0;
+	}
+	for (size_t j = 0; j < zh->ncoil; ++j)
+	{
+		solb_eval_batch(&zh->coils[j], ro, zo, m, Brj, Bzj);
+		for (size_t i = 0; i < m; ++i)
+		{
+			Bro[i] += Brj[i];
+			Bzo[i] += Bzj[i];
+		}
+	}
+	for (size_t i = 0; i < m; ++i)
+	{
+		Br[idx[i]] = Bro[i];
+		Bz[idx[i]] = Bzo[i];
+	}
+}
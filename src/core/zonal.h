@@ -0,0 +1,48 @@
+/**
+ * zonal.h
+ *
+ * Zonal harmonic (Legendre) expansion of the field of a coil set about a
+ * point on its axis. Inside the sphere of convergence the field takes a
+ * single Legendre recurrence per probe instead of the elliptic integrals of
+ * every coil; outside of it the expansion falls back to the direct method.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __ZONAL_H__
+#define __ZONAL_H__
+
+#include "solb.h"
+
+#define ZH_ORDER_MAX 48
+#define ZH_DEFAULT_ORDER 24
+#define ZH_DEFAULT_TOL 1e-10
+
+/* Expansion Bz(0, z0 + t) = SIGMA_n b[n] * t ** n of the on-axis field, which
+ * defines the field everywhere inside the sphere through (0, z0) that touches
+ * the nearest winding. */
+typedef struct _zh_expansion_t
+{
+	double z0;				/* Center of the expansion on the axis */
+	double rc;				/* Radius of the sphere of convergence */
+	double rmax;			/* Radius within which the tolerance is met */
+	double scale;			/* Field magnitude the tolerance is relative to */
+	int order;
+	double b[ZH_ORDER_MAX + 1];	/* On-axis Taylor coefficients in T / m ** n */
+	double br[ZH_ORDER_MAX + 1];	/* b[n] / (n + 1) of the radial component */
+	double c1[ZH_ORDER_MAX + 1];	/* (2n + 1) / (n + 1) of the recurrence */
+	double c2[ZH_ORDER_MAX + 1];	/* n / (n + 1) of the recurrence */
+	const solb_coil_t *coils;	/* Direct evaluation outside rmax */
+	size_t ncoil;
+} zh_expansion_t;
+
+/* Public interfaces. */
+int zh_build(const solb_coil_t *coils, size_t ncoil, double z0, int order,
+		double tol, zh_expansion_t *zh);
+double zh_error(const zh_expansion_t *zh, double rho);
+int zh_inside(const zh_expansion_t *zh, double r, double z);
+mag_field_2d_t zh_eval(const zh_expansion_t *zh, double r, double z);
+void zh_eval_batch(const zh_expansion_t *zh, const double *r, const double *z,
+		size_t n, double *Br, double *Bz);
+
+#endif
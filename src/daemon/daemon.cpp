@@ -0,0 +1,553 @@
+/**
+ * daemon.cpp
+ *
+ * Long-lived solver over stdin and stdout or a Unix-domain socket.
+ *
+ * Every connection has a reader thread of its own, which parses whole
+ * requests, probes included, and queues them in arrival order. A single
+ * evaluator takes whatever is queued at once as a batch, up to
+ * DAEMON_BATCH_MAX probes; with more than one connection open, a small
+ * batch waits up to DAEMON_LINGER_US for more requests to join it. The
+ * probes of a batch are evaluated per coil set as one tiled, parallel run,
+ * and the replies go out in batch order. Loads, drops and other requests
+ * are never batched, so that a set swapped in by a client applies to the
+ * requests it sends afterwards and to none before.
+ *
+ * Coils are never split into groups, so that the answer to a probe does not
+ * depend on the requests it shares a batch with. Numbers of a reply are
+ * written in the shortest form that reads back to the same double.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <charconv>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <omp.h>
+
+#include "daemon.h"
+#include "../io/text-io.h"
+#include "../tile/tile-sched.h"
+
+/* Kinds of requests. */
+enum
+{
+	DAEMON_EVAL,
+	DAEMON_LOAD,
+	DAEMON_DROP,
+	DAEMON_LIST,
+	DAEMON_QUIT,
+	DAEMON_SHUTDOWN,
+	DAEMON_ERROR
+};
+
+/* A client; both ends are the same socket, or stdin and stdout. */
+typedef struct _daemon_conn_t
+{
+	int in_fd;
+	int out_fd;
+} daemon_conn_t;
+
+typedef struct _daemon_req_t
+{
+	daemon_conn_t *conn;
+	int kind;
+	std::string id;
+	std::string arg;		/* File of a load, message of an error */
+	std::vector<double> r;
+	std::vector<double> z;
+	std::vector<double> res;	/* Outputs of every probe in turn */
+} daemon_req_t;
+
+/* Requests of every connection in arrival order. */
+typedef struct _daemon_queue_t
+{
+	std::mutex mtx;
+	std::condition_variable ready;
+	std::deque<daemon_req_t *> reqs;
+	size_t probes;			/* Probes queued */
+	size_t nconn;			/* Connections open */
+} daemon_queue_t;
+
+/* Write all of data to fd; a client gone is noticed by its reader. */
+static void
+daemon_write(int fd, const char *data, size_t len)
+{
+	while (len > 0)
+	{
+		ssize_t k = write(fd, data, len);
+		if (k < 0 && errno == EINTR)
+			continue;
+		if (k <= 0)
+			return;
+		data += k;
+		len -= k;
+	}
+}
+
+static void
+daemon_push(daemon_queue_t *queue, daemon_req_t *req)
+{
+	std::lock_guard<std::mutex> lock(queue->mtx);
+	queue->reqs.push_back(req);
+	queue->probes += req->r.size();
+	queue->ready.notify_one();
+}
+
+/* Whitespace-separated words of a line. */
+static std::vector<std::string>
+daemon_words(const char *line)
+{
+	std::vector<std::string> words;
+	const char *p = line;
+	while (*p != '\0')
+	{
+		while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+			++p;
+		const char *q = p;
+		while (*q != '\0' && *q != ' ' && *q != '\t' && *q != '\r' && *q != '\n')
+			++q;
+		if (q > p)
+			words.push_back(std::string(p, q));
+		p = q;
+	}
+	return words;
+}
+
+/* Probe line of an eval request: r and z, and nothing else. */
+static int
+daemon_probe(const char *line, double *r, double *z)
+{
+	char *end;
+	*r = strtod(line, &end);
+	if (end == line)
+		return 0;
+	const char *p = end;
+	*z = strtod(p, &end);
+	if (end == p)
+		return 0;
+	while (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n')
+		++end;
+	return *end == '\0';
+}
+
+/* Parse the requests of a connection until it closes or quits. */
+static void
+daemon_read(daemon_queue_t *queue, daemon_conn_t *conn)
+{
+	FILE *fp = fdopen(dup(conn->in_fd), "r");
+	char *line = NULL;
+	size_t cap = 0;
+	int quit = 0;
+	while (!quit && fp != NULL && getline(&line, &cap, fp) >= 0)
+	{
+		std::vector<std::string> w = daemon_words(line);
+		if (w.empty())
+			continue;
+
+		daemon_req_t *req = new daemon_req_t;
+		req->conn = conn;
+		req->kind = DAEMON_ERROR;
+		const std::string &cmd = w[0];
+		if (cmd == "eval" && w.size() == 3)
+		{
+			/* strtoul() would take "-1" for SIZE_MAX; the probe lines are never read then */
+			char *end;
+			size_t n = strtoul(w[2].c_str(), &end, 10);
+			req->kind = (w[2][0] >= '0' && w[2][0] <= '9' && *end == '\0'
+					&& n <= DAEMON_BATCH_MAX) ? DAEMON_EVAL : DAEMON_ERROR;
+			req->id = w[1];
+			req->arg = "Wrong number of probes " + w[2] + ", at most "
+				+ std::to_string(DAEMON_BATCH_MAX);
+			/* Every probe line is read even after a wrong one, so that the
+			 * rest of the request is not taken for requests of its own */
+			int ok = (req->kind == DAEMON_EVAL);
+			for (size_t i = 0; ok && i < n; ++i)
+			{
+				double r;
+				double z;
+				if (getline(&line, &cap, fp) < 0)
+				{
+					req->kind = DAEMON_ERROR;
+					req->arg = "Wrong probe " + std::to_string(i + 1) + ", expected r and z";
+					break;
+				}
+				if (req->kind == DAEMON_EVAL && !daemon_probe(line, &r, &z))
+				{
+					req->kind = DAEMON_ERROR;
+					req->arg = "Wrong probe " + std::to_string(i + 1) + ", expected r and z";
+				}
+				if (req->kind == DAEMON_EVAL)
+				{
+					req->r.push_back(r);
+					req->z.push_back(z);
+				}
+			}
+			if (req->kind == DAEMON_ERROR)
+			{
+				req->r.clear();
+				req->z.clear();
+			}
+		}
+		else if (cmd == "load" && w.size() == 3)
+		{
+			req->kind = DAEMON_LOAD;
+			req->id = w[1];
+			req->arg = w[2];
+		}
+		else if (cmd == "drop" && w.size() == 2)
+		{
+			req->kind = DAEMON_DROP;
+			req->id = w[1];
+		}
+		else if (cmd == "list" && w.size() == 1)
+			req->kind = DAEMON_LIST;
+		else if (cmd == "shutdown" && w.size() == 1)
+			req->kind = DAEMON_SHUTDOWN;
+		else if (cmd == "quit" && w.size() == 1)
+		{
+			req->kind = DAEMON_QUIT;
+			quit = 1;
+		}
+		else
+			req->arg = "Unknown request " + cmd;
+		daemon_push(queue, req);
+	}
+	free(line);
+	if (fp != NULL)
+		fclose(fp);
+
+	/* The evaluator closes the connection once it has answered the rest */
+	if (!quit)
+	{
+		daemon_req_t *req = new daemon_req_t;
+		req->conn = conn;
+		req->kind = DAEMON_QUIT;
+		daemon_push(queue, req);
+	}
+}
+
+/* Take the next batch; evaluations that arrived together, or a single other request. */
+static void
+daemon_take(daemon_queue_t *queue, std::vector<daemon_req_t *> *batch)
+{
+	std::unique_lock<std::mutex> lock(queue->mtx);
+	queue->ready.wait(lock, [&]() { return !queue->reqs.empty(); });
+
+	/* Other clients may join a small batch */
+	if (queue->nconn > 1 && queue->reqs.front()->kind == DAEMON_EVAL)
+	{
+		auto until = std::chrono::steady_clock::now()
+			+ std::chrono::microseconds(DAEMON_LINGER_US);
+		while (queue->probes < DAEMON_BATCH_MIN && queue->reqs.back()->kind == DAEMON_EVAL
+				&& queue->ready.wait_until(lock, until) == std::cv_status::no_timeout)
+			;
+	}
+
+	batch->clear();
+	size_t probes = 0;
+	while (!queue->reqs.empty())
+	{
+		daemon_req_t *req = queue->reqs.front();
+		if (!batch->empty() && (req->kind != DAEMON_EVAL || batch->front()->kind != DAEMON_EVAL
+					|| probes + req->r.size() > DAEMON_BATCH_MAX))
+			break;
+		batch->push_back(req);
+		probes += req->r.size();
+		queue->probes -= req->r.size();
+		queue->reqs.pop_front();
+	}
+}
+
+/* Load a coil file as a set compiled for conf. */
+static int
+daemon_load(const daemon_conf_t *conf, const char *path, std::vector<solb_coil_t> *ccoils)
+{
+	std::vector<top_solenoid_t> coils;
+	if (!text_parse_coils(path, &coils) || coils.empty())
+		return 0;
+	ccoils->resize(coils.size());
+	for (size_t j = 0; j < coils.size(); ++j)
+	{
+		if (!solb_compile(&coils[j], &(*ccoils)[j], conf->order)
+				|| !solb_set_kernel(&(*ccoils)[j], conf->kernel)
+				|| !solb_set_tier(&(*ccoils)[j], conf->tier))
+			return 0;
+	}
+	return 1;
+}
+
+/* Evaluate a batch of evaluations, a coil set at a time. */
+static void
+daemon_eval(const daemon_conf_t *conf,
+		const std::map<std::string, std::vector<solb_coil_t> > &sets,
+		std::vector<daemon_req_t *> &batch)
+{
+	int nout = conf->grad ? 6 : 2;
+	std::vector<char> done(batch.size(), 0);
+	for (size_t b = 0; b < batch.size(); ++b)
+	{
+		if (done[b])
+			continue;
+		std::vector<size_t> members;
+		size_t n = 0;
+		for (size_t k = b; k < batch.size(); ++k)
+		{
+			if (!done[k] && batch[k]->id == batch[b]->id)
+			{
+				done[k] = 1;
+				members.push_back(k);
+				n += batch[k]->r.size();
+			}
+		}
+		auto it = sets.find(batch[b]->id);
+		if (it == sets.end())
+		{
+			for (size_t k : members)
+			{
+				batch[k]->kind = DAEMON_ERROR;
+				batch[k]->arg = "No coil set " + batch[k]->id;
+			}
+			continue;
+		}
+		if (n == 0)
+			continue;
+
+		std::vector<double> r(n);
+		std::vector<double> z(n);
+		size_t off = 0;
+		for (size_t k : members)
+		{
+			memcpy(&r[off], batch[k]->r.data(), batch[k]->r.size() * sizeof(double));
+			memcpy(&z[off], batch[k]->z.data(), batch[k]->z.size() * sizeof(double));
+			off += batch[k]->r.size();
+		}
+		std::vector<double> res(nout * n);
+		double *out[6];
+		for (int k = 0; k < nout; ++k)
+			out[k] = &res[k * n];
+		tile_job_t tile;
+		tile_init(&tile, it->second.data(), it->second.size(), NULL, conf->tol, conf->grad, n);
+		tile_ungroup(&tile);
+		tile_eval(&tile, r.data(), z.data(), out);
+
+		off = 0;
+		for (size_t k : members)
+		{
+			size_t m = batch[k]->r.size();
+			batch[k]->res.resize(nout * m);
+			for (size_t i = 0; i < m; ++i)
+			{
+				for (int o = 0; o < nout; ++o)
+					batch[k]->res[i * nout + o] = out[o][off + i];
+			}
+			off += m;
+		}
+	}
+}
+
+/* Reply of an evaluation; a line per probe. */
+static void
+daemon_reply_eval(const daemon_req_t *req, int nout, std::string *buf)
+{
+	size_t m = req->r.size();
+	*buf = "ok " + std::to_string(m) + "\n";
+	char line[32 * 6];
+	for (size_t i = 0; i < m; ++i)
+	{
+		char *p = line;
+		for (int o = 0; o < nout; ++o)
+		{
+			if (o > 0)
+				*p++ = ' ';
+			p = std::to_chars(p, line + sizeof(line) - 1, req->res[i * nout + o]).ptr;
+		}
+		*p++ = '\n';
+		buf->append(line, p - line);
+	}
+}
+
+/* Accept clients until the socket is shut down. */
+static void
+daemon_accept(daemon_queue_t *queue, int lfd)
+{
+	while (1)
+	{
+		int fd = accept(lfd, NULL, NULL);
+		if (fd < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			return;
+		}
+		daemon_conn_t *conn = new daemon_conn_t;
+		conn->in_fd = fd;
+		conn->out_fd = fd;
+		{
+			std::lock_guard<std::mutex> lock(queue->mtx);
+			++queue->nconn;
+		}
+		std::thread(daemon_read, queue, conn).detach();
+	}
+}
+
+/*
+ * daemon_run
+ * Serve requests over the Unix-domain socket at socket_path, or over stdin
+ * and stdout if NULL, until shut down or, for stdin, until it closes. The
+ * coil file, if not NULL, is loaded as DAEMON_DEFAULT_ID beforehand.
+ * returns 1 on success, 0 on failure
+ */
+int
+daemon_run(const daemon_conf_t *conf, const char *coil_file,
+		const char *socket_path)
+{
+	static const char *label = "daemon_run";
+
+	std::map<std::string, std::vector<solb_coil_t> > sets;
+	if (coil_file != NULL && !daemon_load(conf, coil_file, &sets[DAEMON_DEFAULT_ID]))
+	{
+		fprintf(stderr, "%s: %s: Coils are not properly specified", label, coil_file);
+		return 0;
+	}
+
+	/* Clients that hang up must not take the daemon with them */
+	signal(SIGPIPE, SIG_IGN);
+
+	/* Readers blocked on their clients may outlive this function, and so does their queue */
+	daemon_queue_t *queue = new daemon_queue_t;
+	queue->probes = 0;
+	queue->nconn = 0;
+	int lfd = -1;
+	std::thread acceptor;
+	if (socket_path != NULL)
+	{
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(socket_path) >= sizeof(addr.sun_path))
+		{
+			fprintf(stderr, "%s: %s: Socket path is too long", label, socket_path);
+			return 0;
+		}
+		strcpy(addr.sun_path, socket_path);
+		unlink(socket_path);
+		lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (lfd < 0 || bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+				|| listen(lfd, SOMAXCONN) != 0)
+		{
+			fprintf(stderr, "%s: %s: %s", label, socket_path, strerror(errno));
+			if (lfd >= 0)
+				close(lfd);
+			return 0;
+		}
+		acceptor = std::thread(daemon_accept, queue, lfd);
+	}
+	else
+	{
+		daemon_conn_t *conn = new daemon_conn_t;
+		conn->in_fd = STDIN_FILENO;
+		conn->out_fd = STDOUT_FILENO;
+		queue->nconn = 1;
+		std::thread(daemon_read, queue, conn).detach();
+	}
+
+	int nout = conf->grad ? 6 : 2;
+	std::vector<daemon_req_t *> batch;
+	std::string buf;
+	int running = 1;
+	while (running)
+	{
+		daemon_take(queue, &batch);
+		daemon_req_t *req = batch.front();
+		int kind = req->kind;
+		switch (kind)
+		{
+			case DAEMON_EVAL:
+			{
+				double start = omp_get_wtime();
+				daemon_eval(conf, sets, batch);
+				size_t probes = 0;
+				for (daemon_req_t *e : batch)
+				{
+					if (e->kind == DAEMON_EVAL)
+						daemon_reply_eval(e, nout, &buf);
+					else
+						buf = "error " + e->arg + "\n";
+					daemon_write(e->conn->out_fd, buf.data(), buf.size());
+					probes += e->r.size();
+				}
+				if (conf->log != NULL)
+				{
+					fprintf(conf->log, "%zu requests, %zu probes, %.3f ms\n", batch.size(), probes,
+							(omp_get_wtime() - start) * 1e3);
+					fflush(conf->log);
+				}
+				break;
+			}
+			case DAEMON_LOAD:
+			{
+				std::vector<solb_coil_t> ccoils;
+				if (daemon_load(conf, req->arg.c_str(), &ccoils))
+				{
+					sets[req->id].swap(ccoils);
+					buf = "ok " + req->id + " " + std::to_string(sets[req->id].size()) + "\n";
+				}
+				else
+					buf = "error Coils of " + req->arg + " are not properly specified\n";
+				break;
+			}
+			case DAEMON_DROP:
+				buf = sets.erase(req->id) > 0 ? "ok " + req->id + "\n"
+					: "error No coil set " + req->id + "\n";
+				break;
+			case DAEMON_LIST:
+				buf = "ok " + std::to_string(sets.size()) + "\n";
+				for (auto &set : sets)
+					buf += set.first + " " + std::to_string(set.second.size()) + "\n";
+				break;
+			case DAEMON_SHUTDOWN:
+				buf = "ok\n";
+				running = 0;
+				break;
+			case DAEMON_QUIT:
+			{
+				if (req->conn->in_fd != STDIN_FILENO)
+					close(req->conn->in_fd);
+				delete req->conn;
+				std::lock_guard<std::mutex> lock(queue->mtx);
+				running = --queue->nconn > 0 || socket_path != NULL;
+				break;
+			}
+			default:
+				buf = "error " + req->arg + "\n";
+				break;
+		}
+		if (kind != DAEMON_EVAL && kind != DAEMON_QUIT)
+			daemon_write(req->conn->out_fd, buf.data(), buf.size());
+		for (daemon_req_t *e : batch)
+			delete e;
+	}
+
+	if (lfd >= 0)
+	{
+		shutdown(lfd, SHUT_RDWR);
+		acceptor.join();
+		close(lfd);
+		unlink(socket_path);
+	}
+	return 1;
+}
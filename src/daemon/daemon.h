@@ -0,0 +1,49 @@
+/**
+ * daemon.h
+ *
+ * Long-lived solver. Coil sets are loaded once under an ID, and probe
+ * requests are answered over stdin and stdout or over a Unix-domain socket
+ * until the clients are done. Small requests that arrive together are
+ * evaluated as a single batch per coil set.
+ *
+ * Requests are lines of text; a reply starts with "ok" or "error".
+ *   load ID FILE    Load or replace coil set ID from a coil file
+ *   drop ID         Forget coil set ID
+ *   list            Coil sets loaded, one "ID NCOIL" line each
+ *   eval ID N       Field of set ID at the N probes "r z" of the next N lines;
+ *                   the reply is followed by N lines of Br Bz, and the
+ *                   Jacobian with the gradient on
+ *   quit            Close this connection
+ *   shutdown        Stop the daemon
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __DAEMON_H__
+#define __DAEMON_H__
+
+#include <cstdio>
+
+#include "../core/solb.h"
+
+#define DAEMON_BATCH_MIN 4096 // Probes below which a batch waits for more requests
+#define DAEMON_BATCH_MAX (1<<20) // Most probes of a single batch
+#define DAEMON_LINGER_US 200 // Longest wait for more requests, in microseconds
+#define DAEMON_DEFAULT_ID "default" // ID of the coil set given on the command line
+
+/* Settings shared by every coil set and request. */
+typedef struct _daemon_conf_t
+{
+	int order;				/* Gauss-Legendre order of the coils */
+	int kernel;				/* SOLB_KERNEL_* */
+	int tier;				/* SOLB_TIER_* */
+	double tol;				/* Adaptive quadrature if positive */
+	int grad;				/* Jacobian as well */
+	FILE *log;				/* A line per batch, if not NULL */
+} daemon_conf_t;
+
+/* Public interfaces. */
+int daemon_run(const daemon_conf_t *conf, const char *coil_file,
+		const char *socket_path);
+
+#endif
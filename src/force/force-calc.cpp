@@ -0,0 +1,263 @@
+/**
+ * force-calc.cpp
+ *
+ * Lorentz force integration over magnet coils. Every cross-section is
+ * meshed by a composite Gauss-Legendre rule whose panels end at the edges of
+ * the other windings, where the field has a kink; nodes keep off all edges.
+ * Mesh blocks of every coil are evaluated by the batch kernel of every coil
+ * in parallel and reduced on the fly. Partial sums are kept per block and
+ * added in block order, so that the forces do not depend on scheduling.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "force-calc.h"
+
+#define FORCE_CHUNK 1024 // Mesh points evaluated and reduced at once
+
+/* Composite rule over [lo, hi] of about the given number of panels, split
+ * at every cut strictly inside. */
+static void
+force_axis(double lo, double hi, std::vector<double> cut, int panels,
+		std::vector<double> *x, std::vector<double> *w)
+{
+	const double *xq = gl_nodes(FORCE_ORDER);
+	const double *wq = gl_weights(FORCE_ORDER);
+
+	cut.push_back(lo);
+	cut.push_back(hi);
+	std::sort(cut.begin(), cut.end());
+	double prev = lo;
+	for (size_t c = 0; c < cut.size(); ++c)
+	{
+		double next = cut[c];
+		if (!(next > prev) || next > hi)
+			continue;
+		int np = (int)ceil(panels * (next - prev) / (hi - lo) - 1e-9);
+		np = np < 1 ? 1 : np;
+		double h = (next - prev) / np * 0.5;
+		for (int p = 0; p < np; ++p)
+		{
+			double mid = prev + (2 * p + 1) * h;
+			for (int i = 0; i < FORCE_ORDER; ++i)
+			{
+				x->push_back(mid + h * xq[i]);
+				w->push_back(h * wq[i]);
+			}
+		}
+		prev = next;
+	}
+}
+
+/* Whether hoop stress p should replace q as the extreme point; ties go to
+ * the smaller coordinates. */
+static inline int
+force_better(double p, double q, const force_point_t *pp,
+		const force_point_t *qp)
+{
+	if (p != q)
+		return p > q;
+	return pp->r < qp->r || (pp->r == qp->r && pp->z < qp->z);
+}
+
+static void
+force_merge(force_coil_t *dst, const force_coil_t *src)
+{
+	dst->fz += src->fz;
+	dst->fr += src->fr;
+	if (force_better(src->hmax.hoop, dst->hmax.hoop, &src->hmax, &dst->hmax))
+		dst->hmax = src->hmax;
+	if (force_better(-src->hmin.hoop, -dst->hmin.hoop, &src->hmin, &dst->hmin))
+		dst->hmin = src->hmin;
+}
+
+/*
+ * force_check
+ * Integrate the Lorentz force over every coil under the field of the whole
+ * coil set, on about pr x pz panels of FORCE_ORDER x FORCE_ORDER nodes per
+ * coil. If keep is set, the force density and the hoop stress at every node
+ * are kept in res[k].pts, to be released by force_free().
+ * returns 1 on success, 0 on failure
+ */
+int
+force_check(const solb_coil_t *coils, size_t ncoil, int pr, int pz,
+		int keep, force_coil_t *res)
+{
+	static const char *label = "force_check";
+
+	/* Handle bad inputs. */
+	if (coils == NULL || ncoil == 0)
+	{
+		fprintf(stderr, "%s: No solenoid has been specified.", label);
+		return 0;
+	}
+	if (pr < 1 || pz < 1)
+	{
+		fprintf(stderr, "%s: The mesh needs at least a panel per direction.",
+				label);
+		return 0;
+	}
+
+	force_coil_t init;
+	init.fz = 0;
+	init.fr = 0;
+	init.hmax.r = HUGE_VAL;
+	init.hmax.z = HUGE_VAL;
+	init.hmax.fr = 0;
+	init.hmax.fz = 0;
+	init.hmax.hoop = -HUGE_VAL;
+	init.hmin = init.hmax;
+	init.hmin.hoop = HUGE_VAL;
+	init.npts = 0;
+	init.pts = NULL;
+
+	/* Radial and axial rules of every coil; points run along z first. */
+	std::vector<double> rcut;
+	std::vector<double> zcut;
+	for (size_t j = 0; j < ncoil; ++j)
+	{
+		rcut.push_back(coils[j].a1);
+		rcut.push_back(coils[j].a2);
+		zcut.push_back(coils[j].b1);
+		zcut.push_back(coils[j].b2);
+	}
+	std::vector<std::vector<double> > rx(ncoil);
+	std::vector<std::vector<double> > rw(ncoil);
+	std::vector<std::vector<double> > zx(ncoil);
+	std::vector<std::vector<double> > zw(ncoil);
+
+	/* Blocks never span two coils, so that each one reduces into a single
+	 * partial result. */
+	std::vector<size_t> bcoil;
+	std::vector<size_t> bfirst;
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		force_axis(coils[k].a1, coils[k].a2, rcut, pr, &rx[k], &rw[k]);
+		force_axis(coils[k].b1, coils[k].b2, zcut, pz, &zx[k], &zw[k]);
+		res[k] = init;
+		res[k].npts = rx[k].size() * zx[k].size();
+		if (keep)
+			res[k].pts = new force_point_t[res[k].npts];
+		for (size_t first = 0; first < res[k].npts; first += FORCE_CHUNK)
+		{
+			bcoil.push_back(k);
+			bfirst.push_back(first);
+		}
+	}
+
+	long nchunk = (long)bcoil.size();
+	std::vector<force_coil_t> part(nchunk, init);
+#pragma omp parallel
+	{
+		double r[FORCE_CHUNK];
+		double z[FORCE_CHUNK];
+		double w[FORCE_CHUNK];
+		double Br[FORCE_CHUNK];
+		double Bz[FORCE_CHUNK];
+		double Brj[FORCE_CHUNK];
+		double Bzj[FORCE_CHUNK];
+
+#pragma omp for schedule(dynamic)
+		for (long c = 0; c < nchunk; ++c)
+		{
+			size_t k = bcoil[c];
+			size_t first = bfirst[c];
+			size_t n = std::min((size_t)FORCE_CHUNK, res[k].npts - first);
+			size_t nz = zx[k].size();
+			for (size_t p = 0; p < n; ++p)
+			{
+				size_t ir = (first + p) / nz;
+				size_t iz = (first + p) % nz;
+				r[p] = rx[k][ir];
+				z[p] = zx[k][iz];
+				w[p] = 2 * M_PI * r[p] * rw[k][ir] * zw[k][iz];
+				Br[p] = 0;
+				Bz[p] = 0;
+			}
+			for (size_t j = 0; j < ncoil; ++j)
+			{
+				solb_eval_batch(&coils[j], r, z, n, Brj, Bzj);
+				for (size_t p = 0; p < n; ++p)
+				{
+					Br[p] += Brj[p];
+					Bz[p] += Bzj[p];
+				}
+			}
+
+			force_coil_t *loc = &part[c];
+			for (size_t p = 0; p < n; ++p)
+			{
+				force_point_t pt;
+				pt.r = r[p];
+				pt.z = z[p];
+				pt.fr = coils[k].j * Bz[p];
+				pt.fz = -coils[k].j * Br[p];
+				pt.hoop = r[p] * pt.fr;
+				loc->fr += w[p] * pt.fr;
+				loc->fz += w[p] * pt.fz;
+				if (force_better(pt.hoop, loc->hmax.hoop, &pt, &loc->hmax))
+					loc->hmax = pt;
+				if (force_better(-pt.hoop, -loc->hmin.hoop, &pt, &loc->hmin))
+					loc->hmin = pt;
+				if (keep)
+					res[k].pts[first + p] = pt;
+			}
+		}
+	}
+
+	for (long c = 0; c < nchunk; ++c)
+		force_merge(&res[bcoil[c]], &part[c]);
+	return 1;
+}
+
+void
+force_free(size_t ncoil, force_coil_t *res)
+{
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		delete[] res[k].pts;
+		res[k].pts = NULL;
+	}
+}
+
+/*
+ * force_print
+ * Report of force_check() in the units of the coil file.
+ */
+void
+force_print(FILE *fp, size_t ncoil, const force_coil_t *res)
+{
+	fprintf(fp, " Coil        Fz[N]        Fr[N] Hoop max[MPa]     R[mm]     Z[mm] Hoop min[MPa]     R[mm]     Z[mm]\n");
+	fprintf(fp, " ----------------------------------------------------------------------------------------------------\n");
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		const force_point_t *hi = &res[k].hmax;
+		const force_point_t *lo = &res[k].hmin;
+		fprintf(fp, "%5zu%13.5le%13.5le%14.3lf%10.3lf%10.3lf%14.3lf%10.3lf%10.3lf\n",
+				k + 1, res[k].fz, res[k].fr, hi->hoop * 1e-6, hi->r * 1e3,
+				hi->z * 1e3, lo->hoop * 1e-6, lo->r * 1e3, lo->z * 1e3);
+	}
+}
+
+/*
+ * force_write
+ * Distribution kept by force_check() at every mesh point, in SI units.
+ */
+void
+force_write(FILE *fp, size_t ncoil, const force_coil_t *res)
+{
+	fprintf(fp, "%6s%16s%16s%16s%16s%16s\n", "Coil", "Coord_R", "Coord_Z",
+			"fr", "fz", "Hoop");
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		for (size_t q = 0; q < res[k].npts && res[k].pts != NULL; ++q)
+		{
+			const force_point_t *p = &res[k].pts[q];
+			fprintf(fp, "%6zu%16lf%16lf%16le%16le%16le\n", k + 1, p->r, p->z,
+					p->fr, p->fz, p->hoop);
+		}
+	}
+}
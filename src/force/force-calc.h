@@ -0,0 +1,49 @@
+/**
+ * force-calc.h
+ *
+ * Lorentz force on magnet coils. The body force J x B of every winding is
+ * integrated over its cross-section under the field of the whole coil set;
+ * J = j * phi gives the radial force density j * Bz, the axial one -j * Br
+ * and the hoop stress r * j * Bz of unsupported turns.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __FORCE_CALC_H__
+#define __FORCE_CALC_H__
+
+#include "../core/solb.h"
+
+#define FORCE_ORDER 8 // Gauss-Legendre nodes per panel and direction
+#define FORCE_PANELS_R 2 // Panels across the winding
+#define FORCE_PANELS_Z 8 // Panels along the winding
+
+/* A single mesh point of a coil. */
+typedef struct _force_point_t
+{
+	double r;
+	double z;
+	double fr;				/* Radial force density, N/m^3 */
+	double fz;				/* Axial force density, N/m^3 */
+	double hoop;			/* Hoop stress r * j * Bz, Pa */
+} force_point_t;
+
+/* Reduction of a single coil. */
+typedef struct _force_coil_t
+{
+	double fz;				/* Net axial force, N */
+	double fr;				/* Radial force summed over the winding, N */
+	force_point_t hmax;		/* Point of the highest hoop stress */
+	force_point_t hmin;		/* Point of the lowest hoop stress */
+	size_t npts;
+	force_point_t *pts;		/* Every mesh point, if kept */
+} force_coil_t;
+
+/* Public interfaces. */
+int force_check(const solb_coil_t *coils, size_t ncoil, int pr, int pz,
+		int keep, force_coil_t *res);
+void force_free(size_t ncoil, force_coil_t *res);
+void force_print(FILE *fp, size_t ncoil, const force_coil_t *res);
+void force_write(FILE *fp, size_t ncoil, const force_coil_t *res);
+
+#endif
@@ -1,29 +1,312 @@
-/**
- * ic-calc.cpp
- *
- * Several different methods of calculating Ic violation of magnet coil.
- * - Linear interpolation
- * - Analytic interpolation
- *
- * Version 1.0 @ 08/14/2018
- *
- * Jaerin Lee
- * Applied Superconductivity Laboratory
- * Dept. of Electrical and Computer Engineering
- * Seoul National University
- */
-
-#include "../solb.h"
-
-/* Defines interpolation methodology. */
-#define LINEAR_INTERP
-//#define ANALYTIC_INTERP
-
-/* Define point-mapping policy. */
-//#define
-
-/* Main test code. */
-void icTest(int numSol, top_solenoid_t *sols)
-{
-	
-}
+/**
+ * ic-calc.cpp
+ *
+ * Ic violation of magnet coils against the critical surface, found by
+ * direct evaluation of the field; nothing is interpolated.
+ *
+ * The mesh of every cross-section is evaluated directly in parallel chunks
+ * and reduced on the fly; no field is stored beyond a chunk. The worst
+ * points are then refined between mesh points over small grids evaluated
+ * directly, each finer than the last.
+ *
+ * Version 1.0 @ 08/14/2018
+ *
+ * Jaerin Lee
+ * Applied Superconductivity Laboratory
+ * Dept. of Electrical and Computer Engineering
+ * Seoul National University
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "ic-calc.h"
+
+/* Define point-mapping policy. */
+#define IC_CHUNK 1024 // Mesh points evaluated and reduced at once
+#define IC_REFINE 16 // Subdivisions of the span of a refinement grid
+#define IC_REFINE_PASS 2 // Grids, each spanning two subdivisions of the last
+#define IC_LOAD_ITER 60 // Bisections of the load line
+
+/* Example conductor of icTest(). */
+#define IC_EXAMPLE_JC0 1.5e9
+#define IC_EXAMPLE_B0 2.0
+#define IC_EXAMPLE_ALPHA 1.0
+#define IC_EXAMPLE_K 1.0
+
+/*
+ * ic_load
+ * Fraction I / Ic along the load line of a point carrying current density j
+ * under field (Br, Bz). Scaling the current by s scales the field likewise,
+ * so Ic is reached at s * |j| = Jc(s * B) with the angle unchanged.
+ */
+double
+ic_load(const ic_model_t *model, double j, double Br, double Bz)
+{
+	j = fabs(j);
+	if (j == 0)
+		return 0;
+
+	double beff = sqrt(model->k * model->k * Bz * Bz + Br * Br) / model->b0;
+	double lo = 0;
+	double hi = model->jc0 / j;
+	for (int i = 0; i < IC_LOAD_ITER; ++i)
+	{
+		double s = (lo + hi) * 0.5;
+		double jc = model->jc0 / pow(1 + s * beff, model->alpha);
+		if (s * j < jc)
+			lo = s;
+		else
+			hi = s;
+	}
+	return 2 / (lo + hi);
+}
+
+static inline void
+ic_point(const ic_model_t *model, double j, double r, double z,
+		double Br, double Bz, ic_point_t *p)
+{
+	p->r = r;
+	p->z = z;
+	p->B = sqrt(Br * Br + Bz * Bz);
+	p->angle = atan2(Br, Bz);
+	p->load = ic_load(model, j, Br, Bz);
+}
+
+/* Whether p should replace q as the extreme point; ties go to the smaller
+ * coordinates, so that the reduction does not depend on scheduling. */
+static inline int
+ic_better(double p, double q, const ic_point_t *pp, const ic_point_t *qp)
+{
+	if (p != q)
+		return p > q;
+	return pp->r < qp->r || (pp->r == qp->r && pp->z < qp->z);
+}
+
+static void
+ic_merge(ic_coil_result_t *dst, const ic_coil_result_t *src)
+{
+	if (ic_better(src->bmax.B, dst->bmax.B, &src->bmax, &dst->bmax))
+		dst->bmax = src->bmax;
+	if (ic_better(src->worst.load, dst->worst.load, &src->worst, &dst->worst))
+		dst->worst = src->worst;
+}
+
+/* Direct field of every coil at n points. */
+static void
+ic_direct(const solb_coil_t *coils, size_t ncoil, const double *r,
+		const double *z, size_t n, double *Br, double *Bz)
+{
+	std::vector<double> buf(2 * n);
+	for (size_t p = 0; p < n; ++p)
+	{
+		Br[p] = 0;
+		Bz[p] = 0;
+	}
+	for (size_t j = 0; j < ncoil; ++j)
+	{
+		solb_eval_batch(&coils[j], r, z, n, &buf[0], &buf[n]);
+		for (size_t p = 0; p < n; ++p)
+		{
+			Br[p] += buf[p];
+			Bz[p] += buf[n + p];
+		}
+	}
+}
+
+/* Refine both extreme points of coil k over a grid of the mesh cells
+ * around them, then over the grid cells around the best point found, pass
+ * by pass. The field is evaluated, never interpolated; along a grid line,
+ * |B| and the load of a bilinear interpolant peak at its nodes, which would
+ * leave nothing to find between them. */
+static void
+ic_refine(const solb_coil_t *coils, size_t ncoil, const ic_model_t *model,
+		size_t k, double dr, double dz, ic_coil_result_t *res)
+{
+	const solb_coil_t *coil = &coils[k];
+	const size_t m = (IC_REFINE + 1) * (IC_REFINE + 1);
+	std::vector<double> buf(4 * m);
+	double *r = &buf[0];
+	double *z = r + m;
+	double *Br = z + m;
+	double *Bz = Br + m;
+
+	ic_point_t *targets[2] = { &res->bmax, &res->worst };
+	for (int t = 0; t < 2; ++t)
+	{
+		ic_point_t *p = targets[t];
+		double hr = dr;
+		double hz = dz;
+		for (int pass = 0; pass < IC_REFINE_PASS; ++pass)
+		{
+			double r0 = std::max(coil->a1, p->r - hr);
+			double r1 = std::min(coil->a2, p->r + hr);
+			double z0 = std::max(coil->b1, p->z - hz);
+			double z1 = std::min(coil->b2, p->z + hz);
+			if (!(r1 > r0) || !(z1 > z0))
+				break;
+			for (int i = 0; i <= IC_REFINE; ++i)
+			{
+				for (int j = 0; j <= IC_REFINE; ++j)
+				{
+					r[i * (IC_REFINE + 1) + j] = r0 + (r1 - r0) * i / IC_REFINE;
+					z[i * (IC_REFINE + 1) + j] = z0 + (z1 - z0) * j / IC_REFINE;
+				}
+			}
+			ic_direct(coils, ncoil, r, z, m, Br, Bz);
+			for (size_t q = 0; q < m; ++q)
+			{
+				ic_point_t pt;
+				ic_point(model, coil->j, r[q], z[q], Br[q], Bz[q], &pt);
+				if (t ? pt.load > p->load : pt.B > p->B)
+					*p = pt;
+			}
+			hr = (r1 - r0) / IC_REFINE;
+			hz = (z1 - z0) / IC_REFINE;
+		}
+	}
+}
+
+/*
+ * ic_check
+ * Mesh the cross-section of every coil with nr x nz points, including its
+ * edges, and find the point of the maximum field and of the highest load
+ * of each coil under the field of the whole coil set.
+ * returns 1 on success, 0 on failure
+ */
+int
+ic_check(const solb_coil_t *coils, size_t ncoil, const ic_model_t *model,
+		int nr, int nz, ic_coil_result_t *res)
+{
+	static const char *label = "ic_check";
+
+	/* Handle bad inputs. */
+	if (coils == NULL || ncoil == 0)
+	{
+		fprintf(stderr, "%s: No solenoid has been specified.", label);
+		return 0;
+	}
+	if (!(model->jc0 > 0) || !(model->b0 > 0) || !(model->alpha > 0)
+			|| !(model->k >= 0))
+	{
+		fprintf(stderr, "%s: Wrong critical surface.", label);
+		return 0;
+	}
+	if (nr < 2 || nz < 2)
+	{
+		fprintf(stderr, "%s: The mesh needs at least 2 points per direction.",
+				label);
+		return 0;
+	}
+
+	ic_coil_result_t init;
+	init.bmax.r = HUGE_VAL;
+	init.bmax.z = HUGE_VAL;
+	init.bmax.B = -1;
+	init.bmax.angle = 0;
+	init.bmax.load = 0;
+	init.worst = init.bmax;
+	init.worst.load = -1;
+	for (size_t k = 0; k < ncoil; ++k)
+		res[k] = init;
+
+	size_t per = (size_t)nr * nz;
+	size_t total = per * ncoil;
+	long nchunk = (long)((total + IC_CHUNK - 1) / IC_CHUNK);
+#pragma omp parallel
+	{
+		std::vector<ic_coil_result_t> loc(ncoil, init);
+		double r[IC_CHUNK];
+		double z[IC_CHUNK];
+		double Br[IC_CHUNK];
+		double Bz[IC_CHUNK];
+		double Brj[IC_CHUNK];
+		double Bzj[IC_CHUNK];
+
+#pragma omp for schedule(dynamic)
+		for (long c = 0; c < nchunk; ++c)
+		{
+			size_t first = (size_t)c * IC_CHUNK;
+			size_t n = std::min((size_t)IC_CHUNK, total - first);
+			for (size_t p = 0; p < n; ++p)
+			{
+				const solb_coil_t *coil = &coils[(first + p) / per];
+				size_t q = (first + p) % per;
+				r[p] = coil->a1 + (coil->a2 - coil->a1) * (q / nz) / (nr - 1);
+				z[p] = coil->b1 + (coil->b2 - coil->b1) * (q % nz) / (nz - 1);
+				Br[p] = 0;
+				Bz[p] = 0;
+			}
+			for (size_t j = 0; j < ncoil; ++j)
+			{
+				solb_eval_batch(&coils[j], r, z, n, Brj, Bzj);
+				for (size_t p = 0; p < n; ++p)
+				{
+					Br[p] += Brj[p];
+					Bz[p] += Bzj[p];
+				}
+			}
+			for (size_t p = 0; p < n; ++p)
+			{
+				size_t k = (first + p) / per;
+				ic_coil_result_t pt;
+				ic_point(model, coils[k].j, r[p], z[p], Br[p], Bz[p], &pt.bmax);
+				pt.worst = pt.bmax;
+				ic_merge(&loc[k], &pt);
+			}
+		}
+
+#pragma omp critical
+		for (size_t k = 0; k < ncoil; ++k)
+			ic_merge(&res[k], &loc[k]);
+	}
+
+#pragma omp parallel for schedule(dynamic)
+	for (long k = 0; k < (long)ncoil; ++k)
+	{
+		double dr = (coils[k].a2 - coils[k].a1) / (nr - 1);
+		double dz = (coils[k].b2 - coils[k].b1) / (nz - 1);
+		ic_refine(coils, ncoil, model, k, dr, dz, &res[k]);
+	}
+	return 1;
+}
+
+/*
+ * ic_print
+ * Report of ic_check() in the units of the coil file.
+ */
+void
+ic_print(FILE *fp, size_t ncoil, const ic_coil_result_t *res)
+{
+	fprintf(fp, " Coil    Bmax[T]     R[mm]     Z[mm] Angle[deg]      I/Ic     R[mm]     Z[mm]      B[T] Angle[deg]\n");
+	fprintf(fp, " ----------------------------------------------------------------------------------------------------\n");
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		const ic_point_t *b = &res[k].bmax;
+		const ic_point_t *w = &res[k].worst;
+		fprintf(fp, "%5zu%11.6lf%10.3lf%10.3lf%11.3lf%10.6lf%10.3lf%10.3lf%10.6lf%11.3lf\n",
+				k + 1, b->B, b->r * 1e3, b->z * 1e3, b->angle * 180 / M_PI,
+				w->load, w->r * 1e3, w->z * 1e3, w->B, w->angle * 180 / M_PI);
+	}
+}
+
+/* Main test code. */
+void icTest(int numSol, top_solenoid_t *sols)
+{
+	std::vector<solb_coil_t> coils(numSol);
+	for (int i = 0; i < numSol; ++i)
+	{
+		if (!solb_compile(&sols[i], &coils[i]))
+			return;
+	}
+
+	ic_model_t model;
+	model.jc0 = IC_EXAMPLE_JC0;
+	model.b0 = IC_EXAMPLE_B0;
+	model.alpha = IC_EXAMPLE_ALPHA;
+	model.k = IC_EXAMPLE_K;
+
+	std::vector<ic_coil_result_t> res(numSol);
+	if (ic_check(&coils[0], numSol, &model, IC_MESH_R, IC_MESH_Z, &res[0]))
+		ic_print(stdout, numSol, &res[0]);
+}
@@ -0,0 +1,55 @@
+/**
+ * ic-calc.h
+ *
+ * Critical current check of magnet coils. Every coil cross-section is
+ * meshed, the field of the whole coil set is evaluated at every mesh point,
+ * and the results are reduced on the fly to the maximum field and the worst
+ * load-line point of each coil.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __IC_CALC_H__
+#define __IC_CALC_H__
+
+#include "../core/solb.h"
+
+#define IC_MESH_R 16 // Mesh points across the winding
+#define IC_MESH_Z 64 // Mesh points along the winding
+
+/* Critical surface of the conductor, anisotropic Kim model;
+ * Jc(B, theta) = jc0 / (1 + sqrt((k * Bz) ** 2 + Br ** 2) / b0) ** alpha
+ * where k < 1 weakens the effect of the field parallel to the axis. */
+typedef struct _ic_model_t
+{
+	double jc0;				/* Critical current density at zero field, A/m^2 */
+	double b0;				/* Characteristic field, T */
+	double alpha;
+	double k;
+} ic_model_t;
+
+/* A single point of a coil. */
+typedef struct _ic_point_t
+{
+	double r;
+	double z;
+	double B;				/* |B|, T */
+	double angle;			/* Angle of the field from the axis, rad */
+	double load;			/* I / Ic along the load line */
+} ic_point_t;
+
+/* Reduction of a single coil. */
+typedef struct _ic_coil_result_t
+{
+	ic_point_t bmax;		/* Point of the maximum field */
+	ic_point_t worst;		/* Point of the highest I / Ic */
+} ic_coil_result_t;
+
+/* Public interfaces. */
+double ic_load(const ic_model_t *model, double j, double Br, double Bz);
+int ic_check(const solb_coil_t *coils, size_t ncoil, const ic_model_t *model,
+		int nr, int nz, ic_coil_result_t *res);
+void ic_print(FILE *fp, size_t ncoil, const ic_coil_result_t *res);
+void icTest(int numSol, top_solenoid_t *sols);
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * inductance.cpp
+ *
+ * Mutual inductance matrix of a coil set. Every pair i <= j is a single
+ * task for solb_mutual() on the compiled coils, whose quadrature state is
+ * shared by all pairs; the other half of the matrix is its mirror.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include "inductance.h"
+
+/* Ampere-turns of a coil. */
+static inline double
+ind_turns(const solb_coil_t *coil)
+{
+	return coil->j * (coil->a2 - coil->a1) * (coil->b2 - coil->b1);
+}
+
+/*
+ * ind_matrix
+ * Fill the ncoil x ncoil matrix M, row major, with the mutual inductances
+ * per turn squared of every pair of coils in H; self inductances on the
+ * diagonal.
+ * returns 1 on success, 0 on failure
+ */
+int
+ind_matrix(const solb_coil_t *coils, size_t ncoil, double *M)
+{
+	static const char *label = "ind_matrix";
+
+	/* Handle bad inputs. */
+	if (coils == NULL || ncoil == 0)
+	{
+		fprintf(stderr, "%s: No solenoid has been specified.", label);
+		return 0;
+	}
+	for (size_t k = 0; k < ncoil; ++k)
+	{
+		if (!(coils[k].a2 > coils[k].a1) || !(coils[k].b2 > coils[k].b1))
+		{
+			fprintf(stderr, "%s: Coil %zu has no cross-section.", label, k + 1);
+			return 0;
+		}
+	}
+
+	/* Pair p of the upper triangle, row by row. */
+	long npair = (long)(ncoil * (ncoil + 1) / 2);
+#pragma omp parallel for schedule(dynamic)
+	for (long p = 0; p < npair; ++p)
+	{
+		size_t i = 0;
+		size_t q = (size_t)p;
+		while (q >= ncoil - i)
+		{
+			q -= ncoil - i;
+			++i;
+		}
+		size_t j = i + q;
+		double m = solb_mutual(&coils[i], &coils[j]);
+		M[i * ncoil + j] = m;
+		M[j * ncoil + i] = m;
+	}
+	return 1;
+}
+
+/*
+ * ind_energy
+ * Stored magnetic energy in J, W = 1 / 2 * SIGMA_ij M_ij * NI_i * NI_j,
+ * of the coils at their current densities.
+ */
+double
+ind_energy(const solb_coil_t *coils, size_t ncoil, const double *M)
+{
+	double W = 0;
+	for (size_t i = 0; i < ncoil; ++i)
+	{
+		double s = 0;
+		for (size_t j = 0; j < ncoil; ++j)
+			s += M[i * ncoil + j] * ind_turns(&coils[j]);
+		W += 0.5 * s * ind_turns(&coils[i]);
+	}
+	return W;
+}
+
+/*
+ * ind_print
+ * Report of ind_matrix() with the ampere-turns of every coil and the
+ * stored energy.
+ */
+void
+ind_print(FILE *fp, const solb_coil_t *coils, size_t ncoil, const double *M)
+{
+	fprintf(fp, " Coil       NI[A]  M[H/turn^2]\n");
+	fprintf(fp, " ---------------------------------------------------------\n");
+	for (size_t i = 0; i < ncoil; ++i)
+	{
+		fprintf(fp, "%5zu%12.4le", i + 1, ind_turns(&coils[i]));
+		for (size_t j = 0; j < ncoil; ++j)
+			fprintf(fp, "%14.6le", M[i * ncoil + j]);
+		fprintf(fp, "\n");
+	}
+	fprintf(fp, "\nStored energy : %.6le J\n", ind_energy(coils, ncoil, M));
+}
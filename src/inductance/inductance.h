@@ -0,0 +1,22 @@
+/**
+ * inductance.h
+ *
+ * Mutual inductance matrix and stored energy of a coil set. Inductances are
+ * per turn squared, since the coil file gives current densities only; the
+ * inductance of windings of Ni and Nj turns is Ni * Nj times the entry.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __INDUCTANCE_H__
+#define __INDUCTANCE_H__
+
+#include "../core/solb.h"
+
+/* Public interfaces. */
+int ind_matrix(const solb_coil_t *coils, size_t ncoil, double *M);
+double ind_energy(const solb_coil_t *coils, size_t ncoil, const double *M);
+void ind_print(FILE *fp, const solb_coil_t *coils, size_t ncoil,
+		const double *M);
+
+#endif
@@ -0,0 +1,258 @@
+/**
+ * npy-io.cpp
+ *
+ * Memory-mapped NPY files of float64 rows. Only what the probe and field
+ * files need is supported; version 1.0 to 3.0 headers, little-endian float64
+ * and two-dimensional arrays whose rows are contiguous, that is C order of
+ * shape (rows, n) or Fortran order of shape (n, rows).
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "npy-io.h"
+
+static const char npy_magic[] = "\x93NUMPY";
+#define NPY_MAGIC_LEN 6
+
+/* Value of key in the header dictionary, or NULL. */
+static const char *
+npy_key(const char *hdr, const char *key)
+{
+	const char *p = strstr(hdr, key);
+	if (p == NULL)
+		return NULL;
+	p = strchr(p + strlen(key), ':');
+	if (p == NULL)
+		return NULL;
+	++p;
+	while (*p == ' ')
+		++p;
+	return p;
+}
+
+/*
+ * npy_detect
+ * Whether the file at path starts with the NPY magic string.
+ * returns 1 if it is an NPY file, 0 otherwise
+ */
+int
+npy_detect(const char *path)
+{
+	char buf[NPY_MAGIC_LEN];
+	FILE *fp = fopen(path, "rb");
+	if (fp == NULL)
+		return 0;
+	size_t len = fread(buf, 1, NPY_MAGIC_LEN, fp);
+	fclose(fp);
+	return len == NPY_MAGIC_LEN && memcmp(buf, npy_magic, NPY_MAGIC_LEN) == 0;
+}
+
+/*
+ * npy_name
+ * Whether path names an NPY file by its extension.
+ * returns 1 if it ends with .npy, 0 otherwise
+ */
+int
+npy_name(const char *path)
+{
+	size_t len = strlen(path);
+	return len >= 4 && strcmp(path + len - 4, ".npy") == 0;
+}
+
+/*
+ * npy_open
+ * Map an existing NPY file of float64 with the given number of rows for
+ * reading, and for writing in place as well if writable.
+ * returns 1 on success, 0 on failure
+ */
+int
+npy_open(const char *path, size_t rows, int writable, npy_map_t *map)
+{
+	static const char *label = "npy_open";
+
+	int fd = open(path, writable ? O_RDWR : O_RDONLY);
+	if (fd < 0)
+	{
+		fprintf(stderr, "%s: %s: %s", label, path, strerror(errno));
+		return 0;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < NPY_MAGIC_LEN + 4)
+	{
+		fprintf(stderr, "%s: %s: Not an NPY file.", label, path);
+		close(fd);
+		return 0;
+	}
+	size_t size = st.st_size;
+	void *base = writable ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+		: mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+	{
+		fprintf(stderr, "%s: %s: %s", label, path, strerror(errno));
+		return 0;
+	}
+
+	/* Header; the dictionary is copied to terminate it */
+	const unsigned char *b = (const unsigned char *)base;
+	size_t hlen = 0;
+	size_t off = 0;
+	if (memcmp(b, npy_magic, NPY_MAGIC_LEN) == 0 && b[6] == 1)
+	{
+		hlen = b[8] | (size_t)b[9] << 8;
+		off = 10;
+	}
+	else if (memcmp(b, npy_magic, NPY_MAGIC_LEN) == 0 && (b[6] == 2 || b[6] == 3)
+			&& size >= 12)
+	{
+		hlen = b[8] | (size_t)b[9] << 8 | (size_t)b[10] << 16 | (size_t)b[11] << 24;
+		off = 12;
+	}
+	if (off == 0 || off + hlen > size)
+	{
+		fprintf(stderr, "%s: %s: Not an NPY file.", label, path);
+		munmap(base, size);
+		return 0;
+	}
+	char *hdr = new char[hlen + 1];
+	memcpy(hdr, b + off, hlen);
+	hdr[hlen] = '\0';
+
+	const char *descr = npy_key(hdr, "'descr'");
+	const char *order = npy_key(hdr, "'fortran_order'");
+	const char *shape = npy_key(hdr, "'shape'");
+	size_t d0 = 0;
+	size_t d1 = 0;
+	int ok = descr != NULL && order != NULL && shape != NULL
+		&& strncmp(descr, "'<f8'", 5) == 0
+		&& sscanf(shape, "(%zu ,%zu )", &d0, &d1) == 2;
+	int fortran = ok && strncmp(order, "True", 4) == 0;
+	delete[] hdr;
+	if (!ok || (fortran ? d1 : d0) != rows)
+	{
+		fprintf(stderr, "%s: %s: Expected float64 array of shape (%zu, N) "
+				"or of shape (N, %zu) in Fortran order.", label, path, rows, rows);
+		munmap(base, size);
+		return 0;
+	}
+	size_t n = fortran ? d0 : d1;
+	off += hlen;
+	if (off % sizeof(double) != 0 || size - off < rows * n * sizeof(double))
+	{
+		fprintf(stderr, "%s: %s: Truncated or misaligned array.", label, path);
+		munmap(base, size);
+		return 0;
+	}
+	madvise(base, size, MADV_SEQUENTIAL);
+
+	map->base = base;
+	map->size = size;
+	map->data = (double *)(b + off);
+	map->rows = rows;
+	map->n = n;
+	return 1;
+}
+
+/*
+ * npy_create
+ * Create an NPY file of float64 of shape (rows, n) at path, sized in full,
+ * and map it for writing. The array is left to the caller to fill.
+ * returns 1 on success, 0 on failure
+ */
+int
+npy_create(const char *path, size_t rows, size_t n, npy_map_t *map)
+{
+	static const char *label = "npy_create";
+
+	/* Header padded with spaces to the alignment and closed by a newline */
+	char hdr[NPY_ALIGN * 2];
+	int len = snprintf(hdr + 10, sizeof(hdr) - 10,
+			"{'descr': '<f8', 'fortran_order': False, 'shape': (%zu, %zu), }",
+			rows, n);
+	size_t off = (10 + len + 1 + NPY_ALIGN - 1) / NPY_ALIGN * NPY_ALIGN;
+	memcpy(hdr, npy_magic, NPY_MAGIC_LEN);
+	hdr[6] = 1;
+	hdr[7] = 0;
+	hdr[8] = (char)((off - 10) & 0xff);
+	hdr[9] = (char)((off - 10) >> 8);
+	memset(hdr + 10 + len, ' ', off - 10 - len - 1);
+	hdr[off - 1] = '\n';
+
+	size_t size = off + rows * n * sizeof(double);
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		fprintf(stderr, "%s: %s: %s", label, path, strerror(errno));
+		return 0;
+	}
+
+	/* Reserve the blocks now; running out of disk under a map would kill
+	 * the process later instead */
+	int err = posix_fallocate(fd, 0, size);
+	if (err == EINVAL || err == EOPNOTSUPP)
+		err = ftruncate(fd, size) == 0 ? 0 : errno;
+	if (err != 0)
+	{
+		fprintf(stderr, "%s: %s: %s", label, path, strerror(err));
+		close(fd);
+		return 0;
+	}
+	void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+	{
+		fprintf(stderr, "%s: %s: %s", label, path, strerror(errno));
+		return 0;
+	}
+	memcpy(base, hdr, off);
+
+	map->base = base;
+	map->size = size;
+	map->data = (double *)((char *)base + off);
+	map->rows = rows;
+	map->n = n;
+	return 1;
+}
+
+/*
+ * npy_release
+ * Drop the pages of elements first to first + n - 1 of every row from
+ * memory; pages written are kept by the file, and any page is read back
+ * if touched again. Pages shared with other elements are kept.
+ */
+void
+npy_release(npy_map_t *map, size_t first, size_t n)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	for (size_t k = 0; k < map->rows; ++k)
+	{
+		size_t begin = (size_t)(map->data + k * map->n + first) - (size_t)map->base;
+		size_t end = begin + n * sizeof(double);
+		begin = (begin + page - 1) / page * page;
+		end = end / page * page;
+		if (end > begin)
+			madvise((char *)map->base + begin, end - begin, MADV_DONTNEED);
+	}
+}
+
+/*
+ * npy_close
+ * Unmap a file of npy_open() or npy_create(); the contents of the latter
+ * are left to the kernel to write back.
+ */
+void
+npy_close(npy_map_t *map)
+{
+	if (map->base != NULL)
+		munmap(map->base, map->size);
+	map->base = NULL;
+	map->data = NULL;
+}
@@ -0,0 +1,38 @@
+/**
+ * npy-io.h
+ *
+ * Binary probe input and field output in the NPY format of NumPy. Arrays are
+ * float64, little endian and stored row by row, one row per quantity, so
+ * that every quantity is a contiguous array of its own. Files are accessed
+ * through memory maps; the probes are read in place and the results are
+ * written by the workers straight into the output file.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __NPY_IO_H__
+#define __NPY_IO_H__
+
+#include <cstddef>
+
+#define NPY_ALIGN 64 // Alignment of the array data in the file, as NumPy does
+
+/* A float64 array of rows x n mapped from a file; row k is data + k * n. */
+typedef struct _npy_map_t
+{
+	void *base;				/* Start of the mapping */
+	size_t size;			/* Length of the mapping in bytes */
+	double *data;
+	size_t rows;
+	size_t n;
+} npy_map_t;
+
+/* Public interfaces. */
+int npy_detect(const char *path);
+int npy_name(const char *path);
+int npy_open(const char *path, size_t rows, int writable, npy_map_t *map);
+int npy_create(const char *path, size_t rows, size_t n, npy_map_t *map);
+void npy_release(npy_map_t *map, size_t first, size_t n);
+void npy_close(npy_map_t *map);
+
+#endif
@@ -0,0 +1,703 @@
+/**
+ * text-io.cpp
+ *
+ * Memory-mapped text parsers. Numbers are read by std::from_chars, which is
+ * locale-free and correctly rounded; a Fortran exponent D or d is taken
+ * apart, since from_chars knows only e and E.
+ *
+ * Coil file
+ * Five numbers per line; A1, A2, B1, B2 in mm and J in A/mm^2. A number
+ * with a D exponent is scaled by the exponent from these units into SI
+ * units, and one without is taken as is, as the original parser did.
+ *
+ * Probe file
+ * Two numbers per line, r and z in m; anything after them is ignored. The
+ * file is split into chunks ending at line ends. A first pass counts the
+ * lines of every chunk, and a second one parses each chunk into its own
+ * place of the arrays; blank lines are squeezed out at the end. A stream
+ * parses the file the same way, a window of lines at a time, and drops the
+ * pages of the windows done, so that its memory does not grow with the
+ * file.
+ *
+ * Output
+ * Numbers are formatted by std::to_chars, which gives the digits of printf
+ * in the C locale, padded to the width of %16lf. Blocks are taken by the
+ * workers in increasing order and go to a ring of TEXT_PIPE_DEPTH slots per
+ * worker; a worker waits for its slot only while the writer is a whole
+ * ring behind, and the writer hands runs of finished blocks to a single
+ * writev().
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <omp.h>
+
+#include "text-io.h"
+#include "../core/stats.h"
+
+#define TEXT_NO_EXP INT_MIN // No D exponent is given
+#define TEXT_TOKEN_MAX 64 // Longest number with a D exponent
+
+/* Map the whole file read-only; an empty file maps to NULL. */
+static int
+text_map(const char *path, const char *label, const char **data, size_t *size)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		fprintf(stderr, "%s: %s: %s", label, path, strerror(errno));
+		return 0;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		fprintf(stderr, "%s: %s: %s", label, path, strerror(errno));
+		close(fd);
+		return 0;
+	}
+	*size = st.st_size;
+	*data = NULL;
+	if (*size > 0)
+	{
+		void *base = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (base == MAP_FAILED)
+		{
+			fprintf(stderr, "%s: %s: %s", label, path, strerror(errno));
+			close(fd);
+			return 0;
+		}
+		madvise(base, *size, MADV_SEQUENTIAL);
+		*data = (const char *)base;
+	}
+	close(fd);
+	return 1;
+}
+
+static inline int
+text_blank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/*
+ * text_float
+ * Parse a number at p into its mantissa and D exponent, the latter being
+ * TEXT_NO_EXP if absent.
+ * returns the end of the number, or NULL if there is none
+ */
+static const char *
+text_float(const char *p, const char *end, double *val, int *dexp)
+{
+	/* from_chars takes no plus sign */
+	if (p < end && *p == '+')
+		++p;
+	std::from_chars_result res = std::from_chars(p, end, *val);
+	if (res.ec != std::errc())
+		return NULL;
+	p = res.ptr;
+	*dexp = TEXT_NO_EXP;
+	if (p < end && (*p == 'd' || *p == 'D'))
+	{
+		++p;
+		if (p < end && *p == '+')
+			++p;
+		res = std::from_chars(p, end, *dexp);
+		if (res.ec != std::errc())
+			return NULL;
+		p = res.ptr;
+	}
+	return p;
+}
+
+/* Value of a number of a probe file; one with a D exponent is parsed again
+ * as written with e, so that it is rounded once. */
+static const char *
+text_value(const char *p, const char *end, double *val)
+{
+	int dexp;
+	const char *q = text_float(p, end, val, &dexp);
+	if (q == NULL || dexp == TEXT_NO_EXP)
+		return q;
+
+	char buf[TEXT_TOKEN_MAX];
+	size_t len = q - p;
+	if (len >= TEXT_TOKEN_MAX)
+		return NULL;
+	for (size_t i = 0; i < len; ++i)
+		buf[i] = (p[i] == 'd' || p[i] == 'D') ? 'e' : p[i];
+	const char *b = buf[0] == '+' ? buf + 1 : buf;
+	if (std::from_chars(b, buf + len, *val).ec != std::errc())
+		return NULL;
+	return q;
+}
+
+/*
+ * text_parse_coils
+ * Parse every coil of the coil file at path.
+ * returns 1 on success, 0 on failure
+ */
+int
+text_parse_coils(const char *path, std::vector<top_solenoid_t> *sols)
+{
+	static const char *label = "text_parse_coils";
+
+	const char *data;
+	size_t size;
+	if (!text_map(path, label, &data, &size))
+		return 0;
+
+	int ok = 1;
+	size_t line = 0;
+	const char *p = data;
+	const char *end = data + size;
+	while (ok && p < end)
+	{
+		++line;
+		const char *eol = (const char *)memchr(p, '\n', end - p);
+		if (eol == NULL)
+			eol = end;
+
+		double v[5];
+		int idx = 0;
+		while (1)
+		{
+			while (p < eol && text_blank(*p))
+				++p;
+			if (p == eol)
+				break;
+			if (idx == 5)
+			{
+				fprintf(stderr, "%s: %s:%zu: Wrong number of coil parameters", label, path, line);
+				ok = 0;
+				break;
+			}
+			int dexp;
+			const char *q = text_float(p, eol, &v[idx], &dexp);
+			if (q == NULL || (q < eol && !text_blank(*q)))
+			{
+				fprintf(stderr, "%s: %s:%zu: Wrong floating point expression in the file, "
+						"try %%lf[d|D|e|E]%%d", label, path, line);
+				ok = 0;
+				break;
+			}
+
+			/* Dimensions in mm and current density in A/mm^2 into SI units */
+			int exponent = dexp == TEXT_NO_EXP ? 3 : dexp;
+			if (idx < 4 && exponent != 3)
+				v[idx] *= pow(10, exponent - 3);
+			else if (idx == 4 && exponent != -6)
+				v[idx] *= pow(10, exponent + 6);
+			++idx;
+			p = q;
+		}
+		if (ok && idx > 0 && idx < 5)
+		{
+			fprintf(stderr, "%s: %s:%zu: Wrong number of coil parameters", label, path, line);
+			ok = 0;
+		}
+		if (ok && idx == 5)
+			sols->push_back(top_solenoid_t(v[0], v[1], v[2], v[3], v[4]));
+		p = eol + 1;
+	}
+
+	if (data != NULL)
+		munmap((void *)data, size);
+	return ok;
+}
+
+/* Parse lines of a probe chunk into r and z; returns the number of probes,
+ * and the line of the first error in *bad, if any. */
+static size_t
+text_parse_chunk(const char *p, const char *end, double *r, double *z,
+		size_t *bad)
+{
+	size_t n = 0;
+	size_t line = 0;
+	while (p < end)
+	{
+		++line;
+		const char *eol = (const char *)memchr(p, '\n', end - p);
+		if (eol == NULL)
+			eol = end;
+		while (p < eol && text_blank(*p))
+			++p;
+		if (p < eol)
+		{
+			const char *q = text_value(p, eol, &r[n]);
+			if (q != NULL && q < eol && text_blank(*q))
+			{
+				while (q < eol && text_blank(*q))
+					++q;
+				q = text_value(q, eol, &z[n]);
+			}
+			else
+				q = NULL;
+			if (q == NULL)
+			{
+				*bad = line;
+				return n;
+			}
+			++n;
+		}
+		p = eol + 1;
+	}
+	return n;
+}
+
+/* Parse the lines of data[begin, end) into r and z in parallel; line0 is
+ * the number of lines before begin, for messages, and *lines receives the
+ * number of lines of the range. */
+static int
+text_parse_range(const char *data, size_t begin, size_t end, size_t line0,
+		const char *path, const char *label, std::vector<double> *r,
+		std::vector<double> *z, size_t *lines)
+{
+	/* Chunks end right after a line end */
+	size_t size = end - begin;
+	size_t nchunk = size / TEXT_MIN_CHUNK;
+	size_t nthread = omp_get_max_threads() * 4;
+	nchunk = nchunk < 1 ? 1 : nchunk > nthread ? nthread : nchunk;
+	std::vector<size_t> bound(nchunk + 1);
+	bound[0] = begin;
+	bound[nchunk] = end;
+	for (size_t k = 1; k < nchunk; ++k)
+	{
+		size_t b = begin + size * k / nchunk;
+		const char *eol = (const char *)memchr(data + b, '\n', end - b);
+		b = eol == NULL ? end : eol + 1 - data;
+		bound[k] = b > bound[k - 1] ? b : bound[k - 1];
+	}
+
+	/* Lines of every chunk */
+	std::vector<size_t> first(nchunk + 1);
+#pragma omp parallel for schedule(static)
+	for (long k = 0; k < (long)nchunk; ++k)
+	{
+		const char *p = data + bound[k];
+		const char *last = data + bound[k + 1];
+		size_t count = 0;
+		while (p < last && (p = (const char *)memchr(p, '\n', last - p)) != NULL)
+		{
+			++count;
+			++p;
+		}
+		if (bound[k + 1] > bound[k] && data[bound[k + 1] - 1] != '\n')
+			++count;
+		first[k + 1] = count;
+	}
+	first[0] = 0;
+	for (size_t k = 0; k < nchunk; ++k)
+		first[k + 1] += first[k];
+	*lines = first[nchunk];
+
+	r->resize(first[nchunk]);
+	z->resize(first[nchunk]);
+	std::vector<size_t> count(nchunk);
+	std::vector<size_t> bad(nchunk, 0);
+#pragma omp parallel for schedule(dynamic)
+	for (long k = 0; k < (long)nchunk; ++k)
+		count[k] = text_parse_chunk(data + bound[k], data + bound[k + 1],
+				r->data() + first[k], z->data() + first[k], &bad[k]);
+
+	size_t n = 0;
+	for (size_t k = 0; k < nchunk; ++k)
+	{
+		if (bad[k] != 0)
+		{
+			fprintf(stderr, "%s: %s:%zu: Wrong probe, expected r and z", label, path,
+					line0 + first[k] + bad[k]);
+			r->clear();
+			z->clear();
+			return 0;
+		}
+		if (n != first[k])
+		{
+			memmove(r->data() + n, r->data() + first[k], count[k] * sizeof(double));
+			memmove(z->data() + n, z->data() + first[k], count[k] * sizeof(double));
+		}
+		n += count[k];
+	}
+	r->resize(n);
+	z->resize(n);
+	return 1;
+}
+
+/*
+ * text_parse_probes
+ * Parse every probe of the probe file at path into r and z, in parallel.
+ * returns 1 on success, 0 on failure
+ */
+int
+text_parse_probes(const char *path, std::vector<double> *r,
+		std::vector<double> *z)
+{
+	static const char *label = "text_parse_probes";
+
+	const char *data;
+	size_t size;
+	if (!text_map(path, label, &data, &size))
+		return 0;
+	r->clear();
+	z->clear();
+	if (size == 0)
+		return 1;
+
+	size_t lines;
+	int ok = text_parse_range(data, 0, size, 0, path, label, r, z, &lines);
+	munmap((void *)data, size);
+	return ok;
+}
+
+/* Whether the line at p holds anything but blanks; *eol receives its end. */
+static int
+text_filled(const char *p, const char *end, const char **eol)
+{
+	const char *q = (const char *)memchr(p, '\n', end - p);
+	*eol = q == NULL ? end : q;
+	while (p < *eol && text_blank(*p))
+		++p;
+	return p < *eol;
+}
+
+/* Drop the pages of data[begin, end) from memory; they are read again from
+ * the file if touched. */
+static void
+text_release(const char *data, size_t begin, size_t end)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	begin = begin / page * page;
+	end = end / page * page;
+	if (end > begin)
+		madvise((void *)(data + begin), end - begin, MADV_DONTNEED);
+}
+
+/*
+ * text_stream_open
+ * Map the probe file at path for reading window by window.
+ * returns 1 on success, 0 on failure
+ */
+int
+text_stream_open(const char *path, text_stream_t *ts)
+{
+	static const char *label = "text_stream_open";
+
+	ts->path = path;
+	ts->pos = 0;
+	ts->line = 0;
+	ts->line_bytes = TEXT_LINE_GUESS;
+	return text_map(path, label, &ts->data, &ts->size);
+}
+
+/*
+ * text_stream_count
+ * Count the probes of a stream from its current position on, in parallel;
+ * the pages counted are released as well.
+ */
+size_t
+text_stream_count(const text_stream_t *ts)
+{
+	size_t size = ts->size - ts->pos;
+	size_t nchunk = size / TEXT_MIN_CHUNK + 1;
+	std::vector<size_t> bound(nchunk + 1);
+	bound[0] = ts->pos;
+	bound[nchunk] = ts->size;
+	for (size_t k = 1; k < nchunk; ++k)
+	{
+		size_t b = ts->pos + size * k / nchunk;
+		const char *eol = (const char *)memchr(ts->data + b, '\n', ts->size - b);
+		b = eol == NULL ? ts->size : eol + 1 - ts->data;
+		bound[k] = b > bound[k - 1] ? b : bound[k - 1];
+	}
+
+	size_t n = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:n)
+	for (long k = 0; k < (long)nchunk; ++k)
+	{
+		const char *p = ts->data + bound[k];
+		const char *end = ts->data + bound[k + 1];
+		const char *eol;
+		for (; p < end; p = eol + 1)
+			n += text_filled(p, end, &eol);
+		text_release(ts->data, bound[k], bound[k + 1]);
+	}
+	return n;
+}
+
+/*
+ * text_stream_skip
+ * Skip the next n probes of a stream.
+ * returns 1 on success, 0 if the stream ends before
+ */
+int
+text_stream_skip(text_stream_t *ts, size_t n)
+{
+	static const char *label = "text_stream_skip";
+
+	const char *p = ts->data + ts->pos;
+	const char *end = ts->data + ts->size;
+	const char *eol;
+	for (; n > 0 && p < end; p = eol + 1)
+	{
+		n -= text_filled(p, end, &eol);
+		++ts->line;
+	}
+	if (n > 0)
+	{
+		fprintf(stderr, "%s: %s: Fewer probes than the offset", label, ts->path);
+		return 0;
+	}
+	size_t pos = p > end ? ts->size : p - ts->data;
+	text_release(ts->data, ts->pos, pos);
+	ts->pos = pos;
+	return 1;
+}
+
+/*
+ * text_stream_next
+ * Parse the next window of about n probes of a stream into r and z; the
+ * window ends at a line end, and is sized by the mean length of the lines
+ * read so far. Pages of the windows done are released.
+ * returns 1 on success, with no probe at the end of the stream, 0 on failure
+ */
+int
+text_stream_next(text_stream_t *ts, size_t n, std::vector<double> *r,
+		std::vector<double> *z)
+{
+	static const char *label = "text_stream_next";
+
+	r->clear();
+	z->clear();
+	while (r->empty() && ts->pos < ts->size)
+	{
+		size_t end = ts->pos + (size_t)(n * ts->line_bytes) + 1;
+		if (end >= ts->size)
+			end = ts->size;
+		else
+		{
+			const char *eol = (const char *)memchr(ts->data + end, '\n', ts->size - end);
+			end = eol == NULL ? ts->size : eol + 1 - ts->data;
+		}
+
+		size_t lines;
+		if (!text_parse_range(ts->data, ts->pos, end, ts->line, ts->path, label, r, z, &lines))
+			return 0;
+		if (!r->empty())
+			ts->line_bytes = (double)(end - ts->pos) / r->size();
+		text_release(ts->data, ts->pos, end);
+		ts->pos = end;
+		ts->line += lines;
+	}
+	return 1;
+}
+
+/* Unmap a stream. */
+void
+text_stream_close(text_stream_t *ts)
+{
+	if (ts->data != NULL)
+		munmap((void *)ts->data, ts->size);
+	ts->data = NULL;
+}
+
+/*
+ * text_truncate_lines
+ * Cut the text file at path after its first n lines, so that it can be
+ * appended to.
+ * returns 1 on success, 0 if it is shorter or on failure
+ */
+int
+text_truncate_lines(const char *path, size_t n)
+{
+	static const char *label = "text_truncate_lines";
+
+	const char *data;
+	size_t size;
+	if (!text_map(path, label, &data, &size))
+		return 0;
+	const char *p = data;
+	const char *end = data + size;
+	for (size_t k = 0; k < n && p != NULL && p < end; ++k)
+	{
+		p = (const char *)memchr(p, '\n', end - p);
+		if (p != NULL && k + 1 < n)
+			++p;
+	}
+	size_t len = (n == 0) ? 0 : (p == NULL || p >= end) ? SIZE_MAX : p + 1 - data;
+	if (data != NULL)
+		munmap((void *)data, size);
+	if (len == SIZE_MAX)
+	{
+		fprintf(stderr, "%s: %s: Fewer than %zu complete lines", label, path, n);
+		return 0;
+	}
+	if (truncate(path, len) != 0)
+	{
+		fprintf(stderr, "%s: %s: %s", label, path, strerror(errno));
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * text_row
+ * Append a row of n numbers formatted as %16lf to buf.
+ */
+void
+text_row(text_buf_t *buf, const double *v, int n)
+{
+	size_t need = buf->len + n * TEXT_FIELD_MAX + 1;
+	if (buf->data.size() < need)
+		buf->data.resize(need);
+
+	char *p = buf->data.data() + buf->len;
+	char tmp[TEXT_FIELD_MAX];
+	for (int k = 0; k < n; ++k)
+	{
+		std::to_chars_result res = std::to_chars(tmp, tmp + TEXT_FIELD_MAX, v[k],
+				std::chars_format::fixed, TEXT_PRECISION);
+		size_t len = res.ptr - tmp;
+		if (len < TEXT_WIDTH)
+		{
+			memset(p, ' ', TEXT_WIDTH - len);
+			p += TEXT_WIDTH - len;
+		}
+		memcpy(p, tmp, len);
+		p += len;
+	}
+	*p++ = '\n';
+	buf->len = p - buf->data.data();
+}
+
+/* Write every byte of iov, resuming after short writes. */
+static int
+text_writev(int fd, struct iovec *iov, int n)
+{
+	while (n > 0)
+	{
+		ssize_t len = writev(fd, iov, n);
+		if (len < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return 0;
+		}
+		while (n > 0 && (size_t)len >= iov->iov_len)
+		{
+			len -= iov->iov_len;
+			++iov;
+			--n;
+		}
+		if (n > 0)
+		{
+			iov->iov_base = (char *)iov->iov_base + len;
+			iov->iov_len -= len;
+		}
+	}
+	return 1;
+}
+
+/*
+ * text_pipe
+ * Fill blocks 0 to nblock - 1 on every worker thread and write them to fp
+ * in order on a thread of its own. Anything buffered in fp goes first.
+ * returns 1 on success, 0 on failure
+ */
+int
+text_pipe(FILE *fp, size_t nblock, text_block_fn fill, void *ctx)
+{
+	static const char *label = "text_pipe";
+
+	if (fflush(fp) != 0)
+	{
+		fprintf(stderr, "%s: %s", label, strerror(errno));
+		return 0;
+	}
+	int fd = fileno(fp);
+	size_t nslot = TEXT_PIPE_DEPTH * omp_get_max_threads();
+	std::vector<text_buf_t> slot(nslot);
+	std::vector<size_t> ready(nslot, SIZE_MAX);	/* Block held by a slot */
+	size_t written = 0;
+	int err = 0;
+	std::mutex mtx;
+	std::condition_variable filled;
+	std::condition_variable drained;
+	std::atomic<size_t> next(0);
+
+	std::thread writer([&]()
+	{
+		struct iovec iov[TEXT_IOV_MAX];
+		size_t w = 0;
+		while (w < nblock)
+		{
+			size_t k = 0;
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				filled.wait(lock, [&] { return ready[w % nslot] == w; });
+				while (w + k < nblock && k < TEXT_IOV_MAX && k < nslot
+						&& ready[(w + k) % nslot] == w + k)
+					++k;
+			}
+			for (size_t i = 0; i < k; ++i)
+			{
+				iov[i].iov_base = slot[(w + i) % nslot].data.data();
+				iov[i].iov_len = slot[(w + i) % nslot].len;
+			}
+
+			/* After a failure the blocks are still drained, so no worker waits forever */
+			unsigned long long t0 = stats_now();
+			if (err == 0 && !text_writev(fd, iov, k))
+				err = errno;
+			stats_time(STATS_T_WRITE, t0);
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				for (size_t i = 0; i < k; ++i)
+					ready[(w + i) % nslot] = SIZE_MAX;
+				written = w + k;
+			}
+			drained.notify_all();
+			w += k;
+		}
+	});
+
+#pragma omp parallel
+	{
+		size_t b;
+		while ((b = next++) < nblock)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				drained.wait(lock, [&] { return b < written + nslot; });
+			}
+			text_buf_t *buf = &slot[b % nslot];
+			buf->len = 0;
+			fill(b, buf, ctx);
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				ready[b % nslot] = b;
+			}
+			filled.notify_one();
+		}
+	}
+	writer.join();
+
+	if (err != 0)
+	{
+		fprintf(stderr, "%s: %s", label, strerror(err));
+		return 0;
+	}
+	return 1;
+}
@@ -0,0 +1,66 @@
+/**
+ * text-io.h
+ *
+ * Parsers of the text coil and probe files. Files are memory mapped; probe
+ * files are split into line-aligned chunks that are parsed in parallel
+ * straight into arrays of r and z. Numbers may carry Fortran exponents,
+ * as in .5000000D+03.
+ *
+ * Text output is pipelined; worker threads compute and format blocks of
+ * rows in any order, and a writer thread puts them on the file in order
+ * while the next blocks are computed.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __TEXT_IO_H__
+#define __TEXT_IO_H__
+
+#include <vector>
+
+#include "../core/topology.h"
+
+#define TEXT_MIN_CHUNK (1<<20) // Smallest chunk of a probe file parsed by a thread, in bytes
+#define TEXT_LINE_GUESS 40.0 // Bytes per probe line assumed for the first window of a stream
+#define TEXT_WIDTH 16 // Width of a number of the output, as %16lf
+#define TEXT_PRECISION 6 // Decimals of a number of the output
+#define TEXT_FIELD_MAX 320 // Longest number of the output, DBL_MAX included
+#define TEXT_PIPE_DEPTH 4 // Blocks in flight per worker thread
+#define TEXT_IOV_MAX 64 // Most blocks put on the file by a single write
+
+/* Window-by-window reading of a probe file. */
+typedef struct _text_stream_t
+{
+	const char *path;
+	const char *data;
+	size_t size;
+	size_t pos;				/* Start of the next window */
+	size_t line;			/* Lines before pos */
+	double line_bytes;		/* Mean bytes per probe so far */
+} text_stream_t;
+
+/* Formatted rows of a block. */
+typedef struct _text_buf_t
+{
+	std::vector<char> data;
+	size_t len;				/* Bytes in use */
+} text_buf_t;
+
+/* Compute and format block into buf, with text_row(). */
+typedef void (*text_block_fn)(size_t block, text_buf_t *buf, void *ctx);
+
+/* Public interfaces. */
+int text_parse_coils(const char *path, std::vector<top_solenoid_t> *sols);
+int text_parse_probes(const char *path, std::vector<double> *r,
+		std::vector<double> *z);
+int text_stream_open(const char *path, text_stream_t *ts);
+size_t text_stream_count(const text_stream_t *ts);
+int text_stream_skip(text_stream_t *ts, size_t n);
+int text_stream_next(text_stream_t *ts, size_t n, std::vector<double> *r,
+		std::vector<double> *z);
+void text_stream_close(text_stream_t *ts);
+int text_truncate_lines(const char *path, size_t n);
+void text_row(text_buf_t *buf, const double *v, int n);
+int text_pipe(FILE *fp, size_t nblock, text_block_fn fill, void *ctx);
+
+#endif
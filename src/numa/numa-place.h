@@ -0,0 +1,42 @@
+/**
+ * numa-place.h
+ *
+ * NUMA-aware placement of the OpenMP workers. The nodes of the machine and
+ * their CPUs are read from sysfs, restricted to the CPUs the process may run
+ * on. Threads are dealt to the nodes in proportion to their CPUs, node by
+ * node, and every thread is bound to the CPUs of its node; work and data are
+ * then cut the same way, so that the pages a thread touches first, and thus
+ * owns, are the ones it works on.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __NUMA_PLACE_H__
+#define __NUMA_PLACE_H__
+
+#include <cstddef>
+#include <vector>
+
+#define NUMA_SYSFS "/sys/devices/system/node"
+
+/* Nodes with CPUs the process may use, and the threads placed on them. */
+typedef struct _numa_topo_t
+{
+	int nnode;
+	std::vector<int> id;			/* System number of every node */
+	std::vector<int> cpu;			/* CPUs, node by node */
+	std::vector<int> first_cpu;		/* First CPU of every node in cpu; nnode + 1 entries */
+	int nthread;					/* Threads placed; 0 before numa_place() */
+	std::vector<int> first_thread;	/* First thread of every node; nnode + 1 entries */
+} numa_topo_t;
+
+/* Public interfaces. */
+int numa_detect(numa_topo_t *topo);
+void numa_restrict(numa_topo_t *topo, int nnode);
+int numa_place(numa_topo_t *topo, int nthread);
+int numa_thread_node(const numa_topo_t *topo, int thread);
+void numa_span(const numa_topo_t *topo, int node, size_t n, size_t *first, size_t *last);
+double *numa_array(size_t n);
+void numa_array_free(double *p, size_t n);
+
+#endif
@@ -1,52 +1,478 @@
-#include "../core/solb.h"
-#include "omp.h"
-
-#define STRESS_TEST_NUM 100000000
-
-void testSimple0();
-void testStress0(int num);
-
-int main()
-{
-	testStress0(STRESS_TEST_NUM);
-	system("pause");
-}
-
-void testSimple0()
-{
-	top_solenoid_t *sol = new top_solenoid_t(.5, .5142, -.21, .21, 4.7619e8);
-	//sol->print();
-	mag_field_2d_t field = solb_single(sol, 0, 0);
-	//field->print();
-	//delete field;
-	delete sol;
-}
-
-void testStress0(int num)
-{
-	time_t begin;
-	time_t end;
-	struct tm *timeinfo;
-
-	printf("Running total %d SolB queries.\n", num);
-
-	time(&begin);
-	timeinfo = localtime(&begin);
-	printf("Test began at %s\n", asctime(timeinfo));
-
-#pragma omp parallel for
-    for (int i = 0; i < num; ++i)
-    {
-        testSimple0();
-    }
-
-	time(&end);
-	timeinfo = localtime(&end);
-	printf("Test ended at %s\n", asctime(timeinfo));
-
-	double elapsed = difftime(end, begin);
-	printf("\nSummary\n");
-	printf("Time Elapsed         : %lf\n", elapsed);
-	printf("Number of Queries    : %d\n", num);
-	printf("Average Process Time : %lf\n", elapsed / num);
-}
+#include "../core/solb.h"
+#include "../core/zonal.h"
+#include "../core/fieldmap.h"
+#include "../inductance/inductance.h"
+#include "../tile/tile-sched.h"
+#include "../numa/numa-place.h"
+#include "omp.h"
+
+#define STRESS_BATCH_SIZE 4096
+#define BACKEND_TEST_NUM 1000000
+#define KERNEL_TEST_NUM 1000000
+#define ZONAL_TEST_NUM 10000000
+#define FIELDMAP_TEST_NUM 10000000
+#define GRAD_TEST_NUM 1000000
+#define WINDING_TEST_NUM 1000000
+#define NUMA_TEST_NUM 2000000
+
+void testBackend0(int num);
+void testKernel0(int num);
+void testZonal0(int num);
+void testFieldMap0(int num);
+void testGrad0(int num);
+void testWinding0(int num);
+void testInductance0();
+void testNuma0(int num);
+
+int main()
+{
+	testBackend0(BACKEND_TEST_NUM);
+	testKernel0(KERNEL_TEST_NUM);
+	testZonal0(ZONAL_TEST_NUM);
+	testFieldMap0(FIELDMAP_TEST_NUM);
+	testGrad0(GRAD_TEST_NUM);
+	testWinding0(WINDING_TEST_NUM);
+	testInductance0();
+	testNuma0(NUMA_TEST_NUM);
+}
+
+void testBackend0(int num)
+{
+	/* Single thread, so that the figure is the per-call cost of the vector
+	 * arithmetic backend. Probes sweep the near field of the solenoid. */
+	top_solenoid_t sol(.5, .5142, -.21, .21, 4.7619e8);
+	double sum = 0;
+
+	double begin = omp_get_wtime();
+	for (int i = 0; i < num; ++i)
+	{
+		mag_field_2d_t field = solb_single(&sol, .7 * (i % 1000) / 1000, .7 * (i / 1000 % 1000) / 1000);
+		sum += field.Bz;
+	}
+	double elapsed = omp_get_wtime() - begin;
+
+	printf("Backend              : %s\n", VM_BACKEND);
+	printf("Number of Queries    : %d\n", num);
+	printf("Average Process Time : %.1lf ns/query (checksum %lf)\n\n", elapsed * 1e9 / num, sum);
+}
+
+void testKernel0(int num)
+{
+	/* Accuracy of the closed-form kernel against the AGM iteration, and the
+	 * single thread cost of both. Probes sweep the near field of the solenoid,
+	 * including its winding and its end faces. */
+	top_solenoid_t sol(.5, .5142, -.21, .21, 4.7619e8);
+	solb_coil_t agm;
+	solb_coil_t carlson;
+	solb_compile(&sol, &agm);
+	solb_compile(&sol, &carlson);
+	solb_set_kernel(&carlson, SOLB_KERNEL_CARLSON);
+
+	double r[STRESS_BATCH_SIZE];
+	double z[STRESS_BATCH_SIZE];
+	double Br0[STRESS_BATCH_SIZE];
+	double Bz0[STRESS_BATCH_SIZE];
+	double Br1[STRESS_BATCH_SIZE];
+	double Bz1[STRESS_BATCH_SIZE];
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		r[i] = .7 * (i % 64) / 64;
+		z[i] = .21 * (i / 64) / 32;
+	}
+
+	solb_eval_batch(&agm, r, z, STRESS_BATCH_SIZE, Br0, Bz0);
+	solb_eval_batch(&carlson, r, z, STRESS_BATCH_SIZE, Br1, Bz1);
+	double maxErr = 0;
+	double sumErr = 0;
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		double mag = sqrt(Br0[i] * Br0[i] + Bz0[i] * Bz0[i]);
+		double err = sqrt((Br1[i] - Br0[i]) * (Br1[i] - Br0[i])
+				+ (Bz1[i] - Bz0[i]) * (Bz1[i] - Bz0[i])) / mag;
+		maxErr = err > maxErr ? err : maxErr;
+		sumErr += err;
+	}
+
+	int nbatch = num / STRESS_BATCH_SIZE;
+	double begin = omp_get_wtime();
+	for (int i = 0; i < nbatch; ++i)
+		solb_eval_batch(&agm, r, z, STRESS_BATCH_SIZE, Br0, Bz0);
+	double tagm = omp_get_wtime() - begin;
+	begin = omp_get_wtime();
+	for (int i = 0; i < nbatch; ++i)
+		solb_eval_batch(&carlson, r, z, STRESS_BATCH_SIZE, Br1, Bz1);
+	double tcarlson = omp_get_wtime() - begin;
+
+	printf("Kernel accuracy      : carlson vs agm, max %.2le, mean %.2le relative\n",
+			maxErr, sumErr / STRESS_BATCH_SIZE);
+	printf("Number of Queries    : %d\n", nbatch * STRESS_BATCH_SIZE);
+	printf("Average Process Time : agm %.1lf ns/query, carlson %.1lf ns/query\n\n",
+			tagm * 1e9 / (nbatch * STRESS_BATCH_SIZE),
+			tcarlson * 1e9 / (nbatch * STRESS_BATCH_SIZE));
+}
+
+void testZonal0(int num)
+{
+	/* A DSV map of the 8-coil magnet of build/coil.txt through its zonal
+	 * expansion, against the direct method; single thread. */
+	static const double spec[8][5] = {
+		{ .5, .5228, -.1974, .1974, 4.761905e8 },
+		{ .5, .5140, -.0672, .0672, -4.761905e8 },
+		{ .5, .5050, .0672, .1932, -4.761905e8 },
+		{ .5, .5050, -.1932, -.0672, -4.761905e8 },
+		{ .5, .5080, .1974, .4054, 3.846154e8 },
+		{ .5, .5080, -.4054, -.1974, 3.846154e8 },
+		{ .5, .5320, .4054, .7774, 3.225806e8 },
+		{ .5, .5320, -.7774, -.4054, 3.225806e8 }
+	};
+	solb_coil_t coils[8];
+	for (int j = 0; j < 8; ++j)
+	{
+		top_solenoid_t sol(spec[j][0], spec[j][1], spec[j][2], spec[j][3], spec[j][4]);
+		solb_compile(&sol, &coils[j]);
+	}
+	zh_expansion_t zh;
+	zh_build(coils, 8, 0, ZH_DEFAULT_ORDER, ZH_DEFAULT_TOL, &zh);
+
+	/* Probes fill the 20 cm sphere. */
+	double r[STRESS_BATCH_SIZE];
+	double z[STRESS_BATCH_SIZE];
+	double Br0[STRESS_BATCH_SIZE];
+	double Bz0[STRESS_BATCH_SIZE];
+	double Br1[STRESS_BATCH_SIZE];
+	double Bz1[STRESS_BATCH_SIZE];
+	double Brj[STRESS_BATCH_SIZE];
+	double Bzj[STRESS_BATCH_SIZE];
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		double rho = .2 * (i % 64) / 64;
+		double theta = M_PI * (i / 64) / 63;
+		r[i] = rho * sin(theta);
+		z[i] = rho * cos(theta);
+	}
+
+	double begin = omp_get_wtime();
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		Br0[i] = 0;
+		Bz0[i] = 0;
+	}
+	for (int j = 0; j < 8; ++j)
+	{
+		solb_eval_batch(&coils[j], r, z, STRESS_BATCH_SIZE, Brj, Bzj);
+		for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+		{
+			Br0[i] += Brj[i];
+			Bz0[i] += Bzj[i];
+		}
+	}
+	double tdirect = omp_get_wtime() - begin;
+
+	int nbatch = num / STRESS_BATCH_SIZE;
+	begin = omp_get_wtime();
+	for (int i = 0; i < nbatch; ++i)
+		zh_eval_batch(&zh, r, z, STRESS_BATCH_SIZE, Br1, Bz1);
+	double tzonal = omp_get_wtime() - begin;
+
+	double maxErr = 0;
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		double err = fabs(Br1[i] - Br0[i]) + fabs(Bz1[i] - Bz0[i]);
+		maxErr = err > maxErr ? err : maxErr;
+	}
+
+	printf("Zonal expansion      : order %d, B0 %.9lf T, converging within %.3lf m, used within %.3lf m\n",
+			zh.order, zh.b[0], zh.rc, zh.rmax);
+	printf("Zonal accuracy       : max %.2le T against the direct method\n", maxErr);
+	printf("Average Process Time : direct %.1lf ns/query, zonal %.1lf ns/query\n\n",
+			tdirect * 1e9 / STRESS_BATCH_SIZE,
+			tzonal * 1e9 / (nbatch * STRESS_BATCH_SIZE));
+}
+
+void testFieldMap0(int num)
+{
+	/* Queries scattered over the bore of the solenoid through a 129 x 129
+	 * field map, against the direct method; single thread. */
+	top_solenoid_t sol(.5, .5142, -.21, .21, 4.7619e8);
+	solb_coil_t coil;
+	solb_compile(&sol, &coil);
+
+	double begin = omp_get_wtime();
+	fm_map_t fm;
+	fm_build(&coil, 1, 0, .45, -.3, .3, 129, 129, &fm);
+	double tbuild = omp_get_wtime() - begin;
+
+	double r[STRESS_BATCH_SIZE];
+	double z[STRESS_BATCH_SIZE];
+	double Br[STRESS_BATCH_SIZE];
+	double Bz[STRESS_BATCH_SIZE];
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		r[i] = .45 * ((i * 2654435761u) % 65536) / 65536;
+		z[i] = .6 * ((i * 40503u) % 65536) / 65536 - .3;
+	}
+
+	begin = omp_get_wtime();
+	solb_eval_batch(&coil, r, z, STRESS_BATCH_SIZE, Br, Bz);
+	double tdirect = omp_get_wtime() - begin;
+
+	int nbatch = num / STRESS_BATCH_SIZE;
+	double t[2];
+	for (int mode = FM_LINEAR; mode <= FM_HERMITE; ++mode)
+	{
+		begin = omp_get_wtime();
+		for (int i = 0; i < nbatch; ++i)
+			fm_eval_batch(&fm, r, z, STRESS_BATCH_SIZE, mode, Br, Bz);
+		t[mode] = omp_get_wtime() - begin;
+	}
+
+	printf("Field map            : 129 x 129 nodes built in %.3lf s\n", tbuild);
+	printf("Field map est. error : linear %.2le T, hermite %.2le T\n",
+			fm.err_est[FM_LINEAR], fm.err_est[FM_HERMITE]);
+	printf("Average Process Time : direct %.1lf ns/query, linear %.1lf ns/query, hermite %.1lf ns/query\n\n",
+			tdirect * 1e9 / STRESS_BATCH_SIZE,
+			t[FM_LINEAR] * 1e9 / (nbatch * STRESS_BATCH_SIZE),
+			t[FM_HERMITE] * 1e9 / (nbatch * STRESS_BATCH_SIZE));
+	fm_free(&fm);
+}
+
+void testGrad0(int num)
+{
+	/* Jacobian of the single pass against central differences of the field,
+	 * and its cost relative to the field alone; single thread. Probes keep
+	 * 1 cm off the winding, where the difference step is resolved. */
+	top_solenoid_t sol(.5, .5142, -.21, .21, 4.7619e8);
+	solb_coil_t coil;
+	solb_compile(&sol, &coil);
+
+	double r[STRESS_BATCH_SIZE];
+	double z[STRESS_BATCH_SIZE];
+	double Br[STRESS_BATCH_SIZE];
+	double Bz[STRESS_BATCH_SIZE];
+	mag_field_grad_2d_t G[STRESS_BATCH_SIZE];
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		r[i] = .01 + .48 * (i % 64) / 64;
+		z[i] = .4 * (i / 64) / 64 - .2;
+	}
+
+	double h = 1e-6;
+	double maxErr = 0;
+	solb_eval_grad_batch(&coil, r, z, STRESS_BATCH_SIZE, G);
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		mag_field_2d_t rp = solb_eval(&coil, r[i] + h, z[i]);
+		mag_field_2d_t rm = solb_eval(&coil, r[i] - h, z[i]);
+		mag_field_2d_t zp = solb_eval(&coil, r[i], z[i] + h);
+		mag_field_2d_t zm = solb_eval(&coil, r[i], z[i] - h);
+		double err = fabs(G[i].dBrdr - (rp.Br - rm.Br) / (2 * h))
+			+ fabs(G[i].dBrdz - (zp.Br - zm.Br) / (2 * h))
+			+ fabs(G[i].dBzdr - (rp.Bz - rm.Bz) / (2 * h))
+			+ fabs(G[i].dBzdz - (zp.Bz - zm.Bz) / (2 * h));
+		maxErr = err > maxErr ? err : maxErr;
+	}
+
+	int nbatch = num / STRESS_BATCH_SIZE;
+	double begin = omp_get_wtime();
+	for (int i = 0; i < nbatch; ++i)
+		solb_eval_batch(&coil, r, z, STRESS_BATCH_SIZE, Br, Bz);
+	double tfield = omp_get_wtime() - begin;
+	begin = omp_get_wtime();
+	for (int i = 0; i < nbatch; ++i)
+		solb_eval_grad_batch(&coil, r, z, STRESS_BATCH_SIZE, G);
+	double tgrad = omp_get_wtime() - begin;
+
+	printf("Gradient accuracy    : max %.2le T/m against central differences\n", maxErr);
+	printf("Average Process Time : field %.1lf ns/query, field and gradient %.1lf ns/query (x%.2lf)\n\n",
+			tfield * 1e9 / (nbatch * STRESS_BATCH_SIZE),
+			tgrad * 1e9 / (nbatch * STRESS_BATCH_SIZE), tgrad / tfield);
+}
+
+void testWinding0(int num)
+{
+	/* Probes inside the winding, up to its end faces, against the adaptive
+	 * quadrature at order 32, and their cost against as many probes in the
+	 * bore, in the default and the fine tier; single thread. The default tier
+	 * is checked against solb_single() as well, whose nodes it keeps. */
+	top_solenoid_t sol(.5, .5228, -.1974, .1974, 4.761905e8);
+	solb_coil_t coil;
+	solb_coil_t ref;
+	solb_compile(&sol, &coil);
+	solb_compile(&sol, &ref, QUAD_ORDER_MAX);
+
+	double r[STRESS_BATCH_SIZE];
+	double z[STRESS_BATCH_SIZE];
+	double rb[STRESS_BATCH_SIZE];
+	double Br[STRESS_BATCH_SIZE];
+	double Bz[STRESS_BATCH_SIZE];
+	mag_field_2d_t B[STRESS_BATCH_SIZE];
+	for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+	{
+		r[i] = sol.a1 + (sol.a2 - sol.a1) * (i % 64 + .5) / 64;
+		z[i] = sol.b1 + (sol.b2 - sol.b1) * (i / 64) / 63;
+		rb[i] = .45 * (i % 64) / 64;
+		B[i] = solb_eval_adaptive(&ref, r[i], z[i], 1e-13, NULL);
+	}
+
+	int tiers[2] = { SOLB_TIER_FULL, SOLB_TIER_FINE };
+	for (int t = 0; t < 2; ++t)
+	{
+		solb_set_tier(&coil, tiers[t]);
+		solb_eval_batch(&coil, r, z, STRESS_BATCH_SIZE, Br, Bz);
+		double maxErr = 0;
+		double sumErr = 0;
+		double maxDiff = 0;
+		for (int i = 0; i < STRESS_BATCH_SIZE; ++i)
+		{
+			double mag = sqrt(B[i].Br * B[i].Br + B[i].Bz * B[i].Bz);
+			double err = sqrt((Br[i] - B[i].Br) * (Br[i] - B[i].Br)
+					+ (Bz[i] - B[i].Bz) * (Bz[i] - B[i].Bz)) / mag;
+			maxErr = err > maxErr ? err : maxErr;
+			sumErr += err;
+			mag_field_2d_t S = solb_single(&sol, r[i], z[i]);
+			double diff = sqrt((Br[i] - S.Br) * (Br[i] - S.Br) + (Bz[i] - S.Bz) * (Bz[i] - S.Bz)) / mag;
+			maxDiff = diff > maxDiff ? diff : maxDiff;
+		}
+
+		int nbatch = num / STRESS_BATCH_SIZE;
+		double begin = omp_get_wtime();
+		for (int i = 0; i < nbatch; ++i)
+			solb_eval_batch(&coil, r, z, STRESS_BATCH_SIZE, Br, Bz);
+		double twinding = omp_get_wtime() - begin;
+		begin = omp_get_wtime();
+		for (int i = 0; i < nbatch; ++i)
+			solb_eval_batch(&coil, rb, z, STRESS_BATCH_SIZE, Br, Bz);
+		double tbore = omp_get_wtime() - begin;
+
+		printf("Winding accuracy     : max %.2le, mean %.2le relative at order %d, %s tier\n",
+				maxErr, sumErr / STRESS_BATCH_SIZE, coil.order, solb_tier_name(tiers[t]));
+		if (tiers[t] == SOLB_TIER_FULL)
+			printf("Against solb_single(): max %.2le relative\n", maxDiff);
+		printf("Average Process Time : winding %.1lf ns/query, bore %.1lf ns/query\n\n",
+				twinding * 1e9 / (nbatch * STRESS_BATCH_SIZE),
+				tbore * 1e9 / (nbatch * STRESS_BATCH_SIZE));
+	}
+}
+
+void testInductance0()
+{
+	/* Self inductance of a thin winding against Nagaoka's formula for a
+	 * current sheet, L = mu0 * pi * a ** 2 / l * K_N, and the matrix of the
+	 * 8-coil magnet of build/coil.txt. */
+	double a = .5;
+	double l = .42;
+	double ksq = 4 * a * a / (4 * a * a + l * l);
+	double k = sqrt(ksq);
+	double kp = sqrt(1 - ksq);
+	double K = std::comp_ellint_1(k);
+	double E = std::comp_ellint_2(k);
+	double KN = 4 / (3 * M_PI * kp) * ((1 - ksq) / ksq * (K - E) + E - k);
+	double Lref = 4e-7 * M_PI * M_PI * a * a / l * KN;
+	top_solenoid_t thin(a - 5e-9, a + 5e-9, -l / 2, l / 2, 4.7619e8);
+	solb_coil_t coil;
+	solb_compile(&thin, &coil);
+	double L = solb_mutual(&coil, &coil);
+
+	static const double spec[8][5] = {
+		{ .5, .5228, -.1974, .1974, 4.761905e8 },
+		{ .5, .5140, -.0672, .0672, -4.761905e8 },
+		{ .5, .5050, .0672, .1932, -4.761905e8 },
+		{ .5, .5050, -.1932, -.0672, -4.761905e8 },
+		{ .5, .5080, .1974, .4054, 3.846154e8 },
+		{ .5, .5080, -.4054, -.1974, 3.846154e8 },
+		{ .5, .5320, .4054, .7774, 3.225806e8 },
+		{ .5, .5320, -.7774, -.4054, 3.225806e8 }
+	};
+	solb_coil_t coils[8];
+	for (int j = 0; j < 8; ++j)
+	{
+		top_solenoid_t sol(spec[j][0], spec[j][1], spec[j][2], spec[j][3], spec[j][4]);
+		solb_compile(&sol, &coils[j]);
+	}
+	double M[64];
+	double begin = omp_get_wtime();
+	ind_matrix(coils, 8, M);
+	double elapsed = omp_get_wtime() - begin;
+
+	printf("Self inductance      : %.9le H/turn^2, Nagaoka %.9le H/turn^2 (%.2le relative)\n",
+			L, Lref, L / Lref - 1);
+	printf("Inductance matrix    : 8 coils in %.3lf s, stored energy %.6le J\n\n",
+			elapsed, ind_energy(coils, 8, M));
+}
+
+void testNuma0(int num)
+{
+	/* Scaling of the 8-coil magnet of build/coil.txt over the NUMA nodes;
+	 * every node count binds a team to the CPUs of its first nodes, whose
+	 * probes and results are first touched by the node evaluating them, and
+	 * efficiency is against a single node. The unplaced team of every CPU
+	 * runs first, as threads stay bound once placed. Probes fill the bore. */
+	static const double spec[8][5] = {
+		{ .5, .5228, -.1974, .1974, 4.761905e8 },
+		{ .5, .5140, -.0672, .0672, -4.761905e8 },
+		{ .5, .5050, .0672, .1932, -4.761905e8 },
+		{ .5, .5050, -.1932, -.0672, -4.761905e8 },
+		{ .5, .5080, .1974, .4054, 3.846154e8 },
+		{ .5, .5080, -.4054, -.1974, 3.846154e8 },
+		{ .5, .5320, .4054, .7774, 3.225806e8 },
+		{ .5, .5320, -.7774, -.4054, 3.225806e8 }
+	};
+	solb_coil_t coils[8];
+	for (int j = 0; j < 8; ++j)
+	{
+		top_solenoid_t sol(spec[j][0], spec[j][1], spec[j][2], spec[j][3], spec[j][4]);
+		solb_compile(&sol, &coils[j]);
+	}
+
+	numa_topo_t topo;
+	if (!numa_detect(&topo))
+		return;
+	std::vector<double> r(num);
+	std::vector<double> z(num);
+	for (int i = 0; i < num; ++i)
+	{
+		r[i] = .45 * ((i * 2654435761u) % 65536) / 65536;
+		z[i] = 1.6 * ((i * 40503u) % 65536) / 65536 - .8;
+	}
+
+	tile_job_t tile;
+	tile_init(&tile, coils, 8, NULL, 0, 0, num);
+	std::vector<double> B(2 * num);
+	double *res[2] = { &B[0], &B[num] };
+	double begin = omp_get_wtime();
+	tile_eval(&tile, &r[0], &z[0], res);
+	double tbase = omp_get_wtime() - begin;
+	printf("NUMA nodes           : %d, %d CPUs\n", topo.nnode, topo.first_cpu[topo.nnode]);
+	printf("Unplaced             : %d threads, %.2lf ns/query (checksum %lf)\n",
+			omp_get_max_threads(), tbase * 1e9 / num, B[num / 2]);
+
+	double rate1 = 0;
+	int threads1 = 0;
+	for (int k = 1; k <= topo.nnode; ++k)
+	{
+		numa_topo_t sub = topo;
+		numa_restrict(&sub, k);
+		if (!numa_place(&sub, sub.first_cpu[k]))
+			return;
+		double *lr = numa_array(4 * (size_t)num);
+		if (lr == NULL)
+			return;
+		double *out[2] = { lr + 2 * (size_t)num, lr + 3 * (size_t)num };
+		tile_init(&tile, coils, 8, NULL, 0, 0, num);
+		tile_touch_numa(&tile, &sub, &r[0], &z[0], lr, lr + num, out);
+		begin = omp_get_wtime();
+		tile_eval_numa(&tile, &sub, lr, lr + num, out);
+		double elapsed = omp_get_wtime() - begin;
+		double rate = num / elapsed;
+		if (k == 1)
+		{
+			rate1 = rate;
+			threads1 = sub.nthread;
+		}
+		printf("Placed on %2d nodes   : %d threads, %.2lf ns/query, speedup %.2lf, efficiency %.1lf%%\n",
+				k, sub.nthread, elapsed * 1e9 / num, rate / rate1,
+				100.0 * rate / rate1 * threads1 / sub.nthread);
+		numa_array_free(lr, 4 * (size_t)num);
+	}
+	printf("\n");
+}
@@ -0,0 +1,396 @@
+/**
+ * tile-sched.cpp
+ *
+ * Tiled probe x coil scheduler.
+ *
+ * A tile holds as many probes as keep its arrays (r, z, the outputs and the
+ * field of a single coil) within a quarter of the L2 cache, since they are
+ * swept once per coil. If the probes make fewer than TILE_MIN_TASKS tiles,
+ * tiles shrink down to TILE_MIN_PROBES first, and only then are the coils
+ * split into groups. The sum of a probe over the coils of a group is taken
+ * in coil order by a single task, whatever the tiling, so the plan decides
+ * the rounding of a result through its groups only.
+ *
+ * Outputs are Br, Bz and, for the Jacobian, dBr/dr, dBr/dz, dBz/dr and
+ * dBz/dz, each an array over the probes.
+ *
+ * Placed on NUMA nodes, the tiles are cut into a contiguous share per node,
+ * in proportion to its threads; a node sweeps its own share first and
+ * takes tiles of the others only when done. Tiles are evaluated alike
+ * wherever they run.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#include <atomic>
+#include <vector>
+#include <unistd.h>
+#include <omp.h>
+
+#include "tile-sched.h"
+
+/* Size of the L2 cache of the machine, in bytes. */
+static size_t
+tile_cache(void)
+{
+	static long size = 0;
+	if (size == 0)
+	{
+		long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+		size = l2 > 0 ? l2 : TILE_CACHE_DEFAULT;
+	}
+	return size;
+}
+
+/*
+ * tile_init
+ * Plan the evaluation of n probes under the coils, or the zonal expansion
+ * zh if not NULL.
+ */
+void
+tile_init(tile_job_t *job, const solb_coil_t *coils, size_t ncoil,
+		const zh_expansion_t *zh, double tol, int grad, size_t n)
+{
+	job->coils = coils;
+	job->ncoil = ncoil;
+	job->zh = grad ? NULL : zh;
+	job->fm = NULL;
+	job->fm_mode = FM_HERMITE;
+	job->plane = mirror_whole(coils, ncoil, &job->zc);
+	job->tol = tol;
+	job->grad = grad;
+	job->n = n;
+
+	/* Tiles within a quarter of the cache */
+	size_t bytes = sizeof(double) * (2 + 2 * tile_outputs(job));
+	size_t probes = tile_cache() / 4 / bytes / TILE_MIN_PROBES * TILE_MIN_PROBES;
+	probes = probes < TILE_MIN_PROBES ? TILE_MIN_PROBES
+		: probes > TILE_MAX_PROBES ? TILE_MAX_PROBES : probes;
+
+	/* Smaller tiles for few probes, and coil groups for fewer still */
+	if ((n + probes - 1) / probes < TILE_MIN_TASKS)
+	{
+		size_t want = (n + TILE_MIN_TASKS - 1) / TILE_MIN_TASKS;
+		want = (want + TILE_MIN_PROBES - 1) / TILE_MIN_PROBES * TILE_MIN_PROBES;
+		probes = want < TILE_MIN_PROBES ? TILE_MIN_PROBES : want;
+	}
+	job->probes = probes;
+	job->ntile = (n + probes - 1) / probes;
+
+	size_t ngroup = 1;
+	if (job->zh == NULL && ncoil > 1 && job->ntile > 0 && job->ntile < TILE_MIN_TASKS)
+	{
+		ngroup = (TILE_MIN_TASKS + job->ntile - 1) / job->ntile;
+		ngroup = ngroup > ncoil ? ncoil : ngroup;
+	}
+	job->coils_per_group = ncoil == 0 ? 0 : (ncoil + ngroup - 1) / ngroup;
+	job->ngroup = ncoil == 0 ? 1 : (ncoil + job->coils_per_group - 1) / job->coils_per_group;
+}
+
+/*
+ * tile_ungroup
+ * Keep every coil in a single group, so that results do not depend on the
+ * number of probes planned at once, as when a run is cut into windows.
+ */
+void
+tile_ungroup(tile_job_t *job)
+{
+	job->coils_per_group = job->ncoil;
+	job->ngroup = 1;
+}
+
+/*
+ * tile_map
+ * Answer the probes on the field map fm by interpolation of the given mode,
+ * and the others by the coils the map was built from, which must be those
+ * of the job. Jobs of the Jacobian keep the coils. The map takes every coil
+ * at once, so that coils are kept in a single group.
+ */
+void
+tile_map(tile_job_t *job, const fm_map_t *fm, int mode)
+{
+	if (job->grad || job->zh != NULL)
+		return;
+	job->fm = fm;
+	job->fm_mode = mode;
+	tile_ungroup(job);
+}
+
+/* Number of output arrays of a job. */
+int
+tile_outputs(const tile_job_t *job)
+{
+	return job->grad ? 6 : 2;
+}
+
+/* Number of probes of a tile. */
+size_t
+tile_size(const tile_job_t *job, size_t tile)
+{
+	size_t first = tile * job->probes;
+	return job->n - first < job->probes ? job->n - first : job->probes;
+}
+
+/* Br of coils mirrored as a whole is +0 on their plane, and so are dBr/dr and
+ * dBz/dz; in every group, so that the sum of the groups is +0 too. */
+static inline void
+tile_plane(const tile_job_t *job, const double *z, size_t m, double *const *out)
+{
+	if (!job->plane)
+		return;
+	mirror_zero(z, m, job->zc, out[0]);
+	if (job->grad)
+	{
+		mirror_zero(z, m, job->zc, out[2]);
+		mirror_zero(z, m, job->zc, out[5]);
+	}
+}
+
+/*
+ * tile_block
+ * Sum of the field of a group of coils at the probes of a tile, written to
+ * out[k][0] onwards; r and z are the arrays of all probes.
+ */
+void
+tile_block(const tile_job_t *job, const double *r, const double *z,
+		size_t tile, size_t group, double *const *out)
+{
+	size_t first = tile * job->probes;
+	size_t m = tile_size(job, tile);
+	r += first;
+	z += first;
+	if (job->zh != NULL)
+	{
+		zh_eval_batch(job->zh, r, z, m, out[0], out[1]);
+		tile_plane(job, z, m, out);
+		return;
+	}
+	if (job->fm != NULL)
+	{
+		fm_eval_batch(job->fm, r, z, m, job->fm_mode, out[0], out[1]);
+		tile_plane(job, z, m, out);
+		return;
+	}
+
+	int nout = tile_outputs(job);
+	for (int k = 0; k < nout; ++k)
+	{
+		for (size_t i = 0; i < m; ++i)
+			out[k][i] = 0;
+	}
+	size_t j0 = group * job->coils_per_group;
+	size_t j1 = j0 + job->coils_per_group < job->ncoil ? j0 + job->coils_per_group : job->ncoil;
+
+	if (job->grad)
+	{
+		std::vector<mag_field_grad_2d_t> G(m);
+		for (size_t j = j0; j < j1; ++j)
+		{
+			solb_eval_grad_batch(&job->coils[j], r, z, m, G.data());
+			for (size_t i = 0; i < m; ++i)
+			{
+				out[0][i] += G[i].Br;
+				out[1][i] += G[i].Bz;
+				out[2][i] += G[i].dBrdr;
+				out[3][i] += G[i].dBrdz;
+				out[4][i] += G[i].dBzdr;
+				out[5][i] += G[i].dBzdz;
+			}
+		}
+		tile_plane(job, z, m, out);
+		return;
+	}
+
+	std::vector<double> buf(2 * m);
+	double *Br = buf.data();
+	double *Bz = Br + m;
+	for (size_t j = j0; j < j1; ++j)
+	{
+		if (job->tol > 0)
+			solb_eval_adaptive_batch(&job->coils[j], r, z, m, job->tol, Br, Bz, NULL);
+		else
+			solb_eval_batch(&job->coils[j], r, z, m, Br, Bz);
+		for (size_t i = 0; i < m; ++i)
+		{
+			out[0][i] += Br[i];
+			out[1][i] += Bz[i];
+		}
+	}
+	tile_plane(job, z, m, out);
+}
+
+/*
+ * tile_eval
+ * Evaluate every probe of a job in parallel into out[k][0] to out[k][n - 1].
+ */
+void
+tile_eval(const tile_job_t *job, const double *r, const double *z,
+		double *const *out)
+{
+	int nout = tile_outputs(job);
+	long ntile = (long)job->ntile;
+	if (job->ngroup <= 1)
+	{
+#pragma omp parallel for schedule(dynamic)
+		for (long t = 0; t < ntile; ++t)
+		{
+			double *o[6];
+			for (int k = 0; k < nout; ++k)
+				o[k] = out[k] + t * job->probes;
+			tile_block(job, r, z, t, 0, o);
+		}
+		return;
+	}
+
+	/* Partial sums of every group, then their sum in group order */
+	size_t n = job->n;
+	long ngroup = (long)job->ngroup;
+	std::vector<double> part(ngroup * nout * n);
+#pragma omp parallel for schedule(dynamic)
+	for (long task = 0; task < ntile * ngroup; ++task)
+	{
+		long t = task / ngroup;
+		long g = task % ngroup;
+		double *o[6];
+		for (int k = 0; k < nout; ++k)
+			o[k] = &part[(g * nout + k) * n + t * job->probes];
+		tile_block(job, r, z, t, g, o);
+	}
+
+#pragma omp parallel for schedule(static)
+	for (long t = 0; t < ntile; ++t)
+	{
+		size_t first = t * job->probes;
+		size_t last = first + tile_size(job, t);
+		for (int k = 0; k < nout; ++k)
+		{
+			for (size_t i = first; i < last; ++i)
+			{
+				double s = part[k * n + i];
+				for (long g = 1; g < ngroup; ++g)
+					s += part[(g * nout + k) * n + i];
+				out[k][i] = s;
+			}
+		}
+	}
+}
+
+/* Tiles [first, last) of a thread of a placed team; its slice of the share
+ * of its node. */
+static void
+tile_slice(const tile_job_t *job, const numa_topo_t *topo, int thread,
+		size_t *first, size_t *last)
+{
+	int node = numa_thread_node(topo, thread);
+	size_t lo;
+	size_t hi;
+	numa_span(topo, node, job->ntile, &lo, &hi);
+	size_t nt = topo->first_thread[node + 1] - topo->first_thread[node];
+	size_t i = thread - topo->first_thread[node];
+	*first = lo + (hi - lo) * i / nt;
+	*last = lo + (hi - lo) * (i + 1) / nt;
+}
+
+/*
+ * tile_touch_numa
+ * Touch the pages of the probes lr, lz and of the outputs of a job first on
+ * the node that is to evaluate them; r and z are copied into lr and lz,
+ * unless the same, and the outputs are cleared.
+ */
+void
+tile_touch_numa(const tile_job_t *job, const numa_topo_t *topo,
+		const double *r, const double *z, double *lr, double *lz, double *const *out)
+{
+	int nout = tile_outputs(job);
+#pragma omp parallel num_threads(topo->nthread)
+	{
+		size_t t0;
+		size_t t1;
+		tile_slice(job, topo, omp_get_thread_num(), &t0, &t1);
+		size_t first = t0 * job->probes;
+		size_t last = t1 * job->probes < job->n ? t1 * job->probes : job->n;
+		for (size_t i = first; i < last; ++i)
+		{
+			if (lr != r)
+				lr[i] = r[i];
+			if (lz != z)
+				lz[i] = z[i];
+		}
+		for (int k = 0; k < nout; ++k)
+		{
+			for (size_t i = first; i < last; ++i)
+				out[k][i] = 0;
+		}
+	}
+}
+
+/*
+ * tile_eval_numa
+ * Evaluate every probe of a job as tile_eval() does, by a team placed with
+ * numa_place(); the coils, and the zonal expansion, are copied to every
+ * node by a thread of its own. The nodes of a field map are shared. Jobs of coil groups, which only arise for
+ * runs too small to spread over the nodes, are left to tile_eval().
+ */
+void
+tile_eval_numa(const tile_job_t *job, const numa_topo_t *topo,
+		const double *r, const double *z, double *const *out)
+{
+	if (topo == NULL || job->ngroup > 1)
+	{
+		tile_eval(job, r, z, out);
+		return;
+	}
+
+	int nnode = topo->nnode;
+	int nout = tile_outputs(job);
+	std::vector<std::atomic<size_t>> next(nnode);
+	std::vector<size_t> last(nnode);
+	for (int k = 0; k < nnode; ++k)
+	{
+		size_t first;
+		numa_span(topo, k, job->ntile, &first, &last[k]);
+		next[k] = first;
+	}
+
+	std::vector<std::vector<solb_coil_t>> coils(nnode);
+	std::vector<zh_expansion_t> zh(nnode);
+	std::vector<fm_map_t> fm(nnode);
+	std::vector<tile_job_t> jobs(nnode, *job);
+#pragma omp parallel num_threads(topo->nthread)
+	{
+		int thread = omp_get_thread_num();
+		int node = numa_thread_node(topo, thread);
+		if (thread == topo->first_thread[node])
+		{
+			coils[node].assign(job->coils, job->coils + job->ncoil);
+			jobs[node].coils = coils[node].data();
+			if (job->zh != NULL)
+			{
+				zh[node] = *job->zh;
+				zh[node].coils = coils[node].data();
+				jobs[node].zh = &zh[node];
+			}
+			if (job->fm != NULL)
+			{
+				fm[node] = *job->fm;
+				fm[node].coils = coils[node].data();
+				jobs[node].fm = &fm[node];
+			}
+		}
+#pragma omp barrier
+
+		/* Own share first, then the others in turn */
+		for (int s = 0; s < nnode; ++s)
+		{
+			int k = (node + s) % nnode;
+			size_t t;
+			while ((t = next[k]++) < last[k])
+			{
+				double *o[6];
+				for (int i = 0; i < nout; ++i)
+					o[i] = out[i] + t * job->probes;
+				tile_block(&jobs[node], r, z, t, 0, o);
+			}
+		}
+	}
+}
@@ -0,0 +1,63 @@
+/**
+ * tile-sched.h
+ *
+ * Race-free evaluation of the field of a coil set at many probes. The work
+ * is cut into tiles of probes by groups of coils; every task sums its coils
+ * in order into a buffer of its own, and the partial sums of the groups are
+ * added in group order afterwards. The plan depends on the number of probes
+ * and coils and on the cache size only, never on the number of threads, so
+ * that the results are reproducible to the bit.
+ *
+ * Version 1.0 @ 10/16/2026
+ */
+
+#ifndef __TILE_SCHED_H__
+#define __TILE_SCHED_H__
+
+#include "../core/solb.h"
+#include "../core/zonal.h"
+#include "../core/fieldmap.h"
+#include "../core/mirror.h"
+#include "../numa/numa-place.h"
+
+#define TILE_MIN_PROBES 64 // Fewest probes of a tile; tiles are multiples of this
+#define TILE_MAX_PROBES 4096 // Most probes of a tile
+#define TILE_MIN_TASKS 256 // Tasks below which coils are split into groups
+#define TILE_CACHE_DEFAULT (1<<18) // Cache size when the system does not tell, in bytes
+
+/* A planned evaluation of n probes. */
+typedef struct _tile_job_t
+{
+	const solb_coil_t *coils;
+	size_t ncoil;
+	const zh_expansion_t *zh;	/* Answers every probe in place of the coils, if not NULL */
+	const fm_map_t *fm;			/* Answers the probes on it in place of the coils, if not NULL */
+	int fm_mode;				/* FM_LINEAR or FM_HERMITE */
+	int plane;					/* Coils mirrored as a whole about z = zc; Br is +0 there */
+	double zc;
+	double tol;					/* Adaptive quadrature if positive */
+	int grad;					/* Jacobian as well, by the fixed-order quadrature */
+	size_t n;
+	size_t probes;				/* Probes per tile */
+	size_t ntile;
+	size_t coils_per_group;
+	size_t ngroup;
+} tile_job_t;
+
+/* Public interfaces. */
+void tile_init(tile_job_t *job, const solb_coil_t *coils, size_t ncoil,
+		const zh_expansion_t *zh, double tol, int grad, size_t n);
+void tile_ungroup(tile_job_t *job);
+void tile_map(tile_job_t *job, const fm_map_t *fm, int mode);
+int tile_outputs(const tile_job_t *job);
+size_t tile_size(const tile_job_t *job, size_t tile);
+void tile_block(const tile_job_t *job, const double *r, const double *z,
+		size_t tile, size_t group, double *const *out);
+void tile_eval(const tile_job_t *job, const double *r, const double *z,
+		double *const *out);
+void tile_touch_numa(const tile_job_t *job, const numa_topo_t *topo,
+		const double *r, const double *z, double *lr, double *lz, double *const *out);
+void tile_eval_numa(const tile_job_t *job, const numa_topo_t *topo,
+		const double *r, const double *z, double *const *out);
+
+#endif